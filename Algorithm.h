@@ -0,0 +1,214 @@
+// Distributed under the MIT license. See the end of the file for details.
+
+#pragma once
+
+#include "ArrayRef.h"
+
+#include <algorithm>
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+namespace cxx {
+
+// Algorithms over array_ref which can be used in constant expressions, e.g.
+// to build sorted lookup tables at compile time:
+//
+//  constexpr auto table = [] {
+//      std::array<int, 4> a = { 3, 1, 4, 2 };
+//      cxx::sort(cxx::array_ref<int>(a));
+//      return a;
+//  }();
+//
+// As for find_byte and search, the search functions return the part of the
+// array starting at the element found, or an empty array at the end.
+
+namespace detail {
+
+constexpr bool is_constant_evaluated() noexcept
+{
+#if __cpp_lib_is_constant_evaluated >= 201811
+    return std::is_constant_evaluated();
+#else
+    return true;
+#endif
+}
+
+template <typename T>
+constexpr void constexpr_swap(T& x, T& y)
+{
+    T t = std::move(x);
+    x = std::move(y);
+    y = std::move(t);
+}
+
+template <typename T, typename Compare>
+constexpr void insertion_sort(T* p, std::ptrdiff_t n, Compare& comp)
+{
+    for (std::ptrdiff_t i = 1; i < n; ++i) {
+        for (std::ptrdiff_t j = i; j > 0 && comp(p[j], p[j - 1]); --j)
+            constexpr_swap(p[j], p[j - 1]);
+    }
+}
+
+template <typename T, typename Compare>
+constexpr void sift_down(T* p, std::ptrdiff_t i, std::ptrdiff_t n, Compare& comp)
+{
+    for (;;) {
+        std::ptrdiff_t c = 2 * i + 1;
+        if (c >= n)
+            return;
+        if (c + 1 < n && comp(p[c], p[c + 1]))
+            ++c;
+        if (!comp(p[i], p[c]))
+            return;
+        constexpr_swap(p[i], p[c]);
+        i = c;
+    }
+}
+
+// Heap sort: O(n log n) without recursion, which keeps constant evaluation
+// within the compilers' step and depth limits.
+template <typename T, typename Compare>
+constexpr void heap_sort(T* p, std::ptrdiff_t n, Compare& comp)
+{
+    for (std::ptrdiff_t i = n / 2; i-- > 0; )
+        sift_down(p, i, n, comp);
+    for (std::ptrdiff_t last = n - 1; last > 0; --last) {
+        constexpr_swap(p[0], p[last]);
+        sift_down(p, 0, last, comp);
+    }
+}
+
+} // namespace detail
+
+// Sorts arr. Not stable. At run time (if the compiler can tell, i.e. in
+// C++20) this calls std::sort.
+template <typename T, typename Compare = std::less<>>
+constexpr void sort(array_ref<T> arr, Compare comp = {})
+{
+    if (!detail::is_constant_evaluated()) {
+        std::sort(arr.data(), arr.data() + arr.size(), comp);
+        return;
+    }
+
+    if (arr.size() <= 16)
+        detail::insertion_sort(arr.data(), arr.size(), comp);
+    else
+        detail::heap_sort(arr.data(), arr.size(), comp);
+}
+
+template <typename T, typename Compare = std::less<>>
+constexpr bool is_sorted(array_ref<T> arr, Compare comp = {})
+{
+    for (std::ptrdiff_t i = 1; i < arr.size(); ++i) {
+        if (comp(arr[i], arr[i - 1]))
+            return false;
+    }
+    return true;
+}
+
+// Returns the part of the sorted array arr starting at the first element
+// which is not less than value.
+template <typename T, typename U, typename Compare = std::less<>>
+constexpr array_ref<T> lower_bound(array_ref<T> arr, U const& value, Compare comp = {})
+{
+    std::ptrdiff_t first = 0;
+    std::ptrdiff_t n = arr.size();
+    while (n > 0) {
+        std::ptrdiff_t const h = n / 2;
+        if (comp(arr[first + h], value)) {
+            first += h + 1;
+            n -= h + 1;
+        } else {
+            n = h;
+        }
+    }
+    return arr.drop_front(first);
+}
+
+// Returns the part of the sorted array arr starting at the first element
+// which is greater than value.
+template <typename T, typename U, typename Compare = std::less<>>
+constexpr array_ref<T> upper_bound(array_ref<T> arr, U const& value, Compare comp = {})
+{
+    std::ptrdiff_t first = 0;
+    std::ptrdiff_t n = arr.size();
+    while (n > 0) {
+        std::ptrdiff_t const h = n / 2;
+        if (!comp(value, arr[first + h])) {
+            first += h + 1;
+            n -= h + 1;
+        } else {
+            n = h;
+        }
+    }
+    return arr.drop_front(first);
+}
+
+// Returns whether the sorted array arr contains an element equivalent to
+// value.
+template <typename T, typename U, typename Compare = std::less<>>
+constexpr bool binary_search(array_ref<T> arr, U const& value, Compare comp = {})
+{
+    auto const r = cxx::lower_bound(arr, value, comp);
+    return !r.empty() && !comp(value, r[0]);
+}
+
+// Returns the part of arr starting at the first element for which pred is
+// true.
+template <typename T, typename Pred>
+constexpr array_ref<T> find_if(array_ref<T> arr, Pred pred)
+{
+    std::ptrdiff_t i = 0;
+    while (i < arr.size() && !pred(arr[i]))
+        ++i;
+    return arr.drop_front(i);
+}
+
+// Returns the part of arr starting at the first element equal to value.
+template <typename T, typename U>
+constexpr array_ref<T> find(array_ref<T> arr, U const& value)
+{
+    return cxx::find_if(arr, [&](auto const& x) { return x == value; });
+}
+
+// Left fold of the elements of arr with op, starting with init.
+template <typename T, typename Acc, typename BinaryOp>
+constexpr Acc reduce(array_ref<T> arr, Acc init, BinaryOp op)
+{
+    for (std::ptrdiff_t i = 0; i < arr.size(); ++i)
+        init = op(std::move(init), arr[i]);
+    return init;
+}
+
+template <typename T, typename Acc>
+constexpr Acc reduce(array_ref<T> arr, Acc init)
+{
+    for (std::ptrdiff_t i = 0; i < arr.size(); ++i)
+        init = std::move(init) + arr[i];
+    return init;
+}
+
+} // namespace cxx
+
+//------------------------------------------------------------------------------
+// Copyright 2017 A. Bolz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
@@ -7,6 +7,18 @@
 #include <iterator>
 #include <type_traits>
 
+#if defined(__has_include)
+#if __has_include(<version>)
+#include <version>
+#endif
+#endif
+#if __cpp_lib_span >= 202002
+#include <span>
+#endif
+#if __cpp_lib_string_view >= 201606
+#include <string_view>
+#endif
+
 namespace cxx {
 
 template <typename From, typename To>
@@ -249,6 +261,30 @@ public:
     {
     }
 
+#if __cpp_lib_span >= 202002
+    template <
+        typename U, size_t Extent,
+        typename = std::enable_if_t< is_array_convertible<U, element_type>::value >
+    >
+    constexpr array_ref(std::span<U, Extent> s) noexcept
+        : data_(s.data())
+        , size_(static_cast<difference_type>(s.size()))
+    {
+    }
+#endif
+
+#if __cpp_lib_string_view >= 201606
+    template <
+        typename CharT, typename Traits,
+        typename = std::enable_if_t< is_array_convertible<CharT const, element_type>::value >
+    >
+    constexpr array_ref(std::basic_string_view<CharT, Traits> s) noexcept
+        : data_(s.data())
+        , size_(static_cast<difference_type>(s.size()))
+    {
+    }
+#endif
+
     template <
         typename Rhs,
         typename = std::enable_if_t<
@@ -409,6 +445,68 @@ array_ref(ContainerT&)
 
 #endif // __cpp_deduction_guides >= 201606
 
+#if __cpp_lib_byte >= 201603
+
+// Returns a view of the object representation of the elements of arr.
+template <typename T>
+array_ref<std::byte const> as_bytes(array_ref<T> arr) noexcept
+{
+    return { reinterpret_cast<std::byte const*>(arr.data()), arr.size_in_bytes() };
+}
+
+template <
+    typename T,
+    typename = std::enable_if_t< !std::is_const<T>::value >
+>
+array_ref<std::byte> as_writable_bytes(array_ref<T> arr) noexcept
+{
+    return { reinterpret_cast<std::byte*>(arr.data()), arr.size_in_bytes() };
+}
+
+#endif // __cpp_lib_byte >= 201603
+
+#if __cpp_lib_span >= 202002
+
+// Returns arr as a std::span with dynamic extent.
+template <typename T>
+constexpr std::span<T> to_span(array_ref<T> arr) noexcept
+{
+    return { arr.data(), static_cast<size_t>(arr.size()) };
+}
+
+// Returns arr as a std::span with static extent. arr must have exactly N
+// elements.
+template <size_t N, typename T>
+constexpr std::span<T, N> to_span(array_ref<T> arr) noexcept
+{
+    assert(arr.size() == static_cast<typename array_ref<T>::difference_type>(N));
+    return std::span<T, N>(arr.data(), N);
+}
+
+#endif // __cpp_lib_span >= 202002
+
+#if __cpp_lib_string_view >= 201606
+
+// Returns arr as a std::basic_string_view.
+template <
+    typename CharT,
+    typename = std::enable_if_t<
+        std::is_same<std::remove_const_t<CharT>, char>::value ||
+        std::is_same<std::remove_const_t<CharT>, wchar_t>::value ||
+#if __cpp_char8_t >= 201811
+        std::is_same<std::remove_const_t<CharT>, char8_t>::value ||
+#endif
+        std::is_same<std::remove_const_t<CharT>, char16_t>::value ||
+        std::is_same<std::remove_const_t<CharT>, char32_t>::value
+    >
+>
+constexpr std::basic_string_view<std::remove_const_t<CharT>> to_string_view(array_ref<CharT> arr) noexcept
+{
+    return { arr.data(), static_cast<size_t>(arr.size()) };
+}
+
+#endif // __cpp_lib_string_view >= 201606
+
 } // namespace cxx
 
 //------------------------------------------------------------------------------
@@ -0,0 +1,184 @@
+// Distributed under the MIT license. See the end of the file for details.
+
+#pragma once
+
+#include "ArrayRef.h"
+
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+
+namespace cxx {
+
+#if __cpp_lib_atomic_ref >= 201806
+
+// Atomic access to the elements of an array of plain T's, using
+// std::atomic_ref. Unlike a std::vector<std::atomic<T>>, the storage can be
+// any array_ref (e.g. a huge_array or a memory-mapped file), and can be
+// accessed non-atomically in phases where there are no concurrent writers.
+//
+// All non-atomic accesses to an element must happen-before or after all
+// atomic accesses to it. The data must satisfy
+// std::atomic_ref<T>::required_alignment.
+template <typename T>
+class atomic_array_ref
+{
+    static_assert(!std::is_const<T>::value, "invalid template argument");
+    static_assert(std::is_trivially_copyable<T>::value, "invalid template argument");
+
+public:
+    using element_type    = T;
+    using value_type      = T;
+    using reference       = std::atomic_ref<T>;
+    using difference_type = std::ptrdiff_t;
+
+    static constexpr std::size_t required_alignment = std::atomic_ref<T>::required_alignment;
+
+private:
+    array_ref<T> arr_;
+
+public:
+    constexpr atomic_array_ref() noexcept = default;
+
+    explicit atomic_array_ref(array_ref<T> arr) noexcept
+        : arr_(arr)
+    {
+        assert(reinterpret_cast<std::uintptr_t>(arr_.data()) % required_alignment == 0);
+    }
+
+    // Returns the underlying (non-atomic) array.
+    array_ref<T> array() const noexcept {
+        return arr_;
+    }
+
+    T* data() const noexcept {
+        return arr_.data();
+    }
+
+    difference_type size() const noexcept {
+        return arr_.size();
+    }
+
+    bool empty() const noexcept {
+        return arr_.empty();
+    }
+
+    reference operator[](difference_type i) const noexcept {
+        return reference(arr_[i]);
+    }
+
+    T load(difference_type i, std::memory_order order = std::memory_order_seq_cst) const noexcept {
+        return reference(arr_[i]).load(order);
+    }
+
+    void store(difference_type i, T value, std::memory_order order = std::memory_order_seq_cst) const noexcept {
+        reference(arr_[i]).store(value, order);
+    }
+
+    T exchange(difference_type i, T value, std::memory_order order = std::memory_order_seq_cst) const noexcept {
+        return reference(arr_[i]).exchange(value, order);
+    }
+
+    bool compare_exchange_weak(difference_type i, T& expected, T desired, std::memory_order order = std::memory_order_seq_cst) const noexcept {
+        return reference(arr_[i]).compare_exchange_weak(expected, desired, order);
+    }
+
+    bool compare_exchange_strong(difference_type i, T& expected, T desired, std::memory_order order = std::memory_order_seq_cst) const noexcept {
+        return reference(arr_[i]).compare_exchange_strong(expected, desired, order);
+    }
+
+    // Integral and floating-point T only.
+    T fetch_add(difference_type i, T value, std::memory_order order = std::memory_order_seq_cst) const noexcept {
+        return reference(arr_[i]).fetch_add(value, order);
+    }
+
+    T fetch_sub(difference_type i, T value, std::memory_order order = std::memory_order_seq_cst) const noexcept {
+        return reference(arr_[i]).fetch_sub(value, order);
+    }
+
+    // Integral T only.
+    T fetch_and(difference_type i, T value, std::memory_order order = std::memory_order_seq_cst) const noexcept {
+        return reference(arr_[i]).fetch_and(value, order);
+    }
+
+    T fetch_or(difference_type i, T value, std::memory_order order = std::memory_order_seq_cst) const noexcept {
+        return reference(arr_[i]).fetch_or(value, order);
+    }
+
+    T fetch_xor(difference_type i, T value, std::memory_order order = std::memory_order_seq_cst) const noexcept {
+        return reference(arr_[i]).fetch_xor(value, order);
+    }
+
+    //--------------------------------------------------------------------------
+    // Bulk operations. Each element is accessed atomically, but the operation
+    // as a whole is not atomic.
+    //--------------------------------------------------------------------------
+
+    // Loads the first dst.size() elements into dst.
+    void load(array_ref<T> dst, std::memory_order order = std::memory_order_relaxed) const noexcept
+    {
+        assert(dst.size() <= size());
+        for (difference_type i = 0; i < dst.size(); ++i)
+            dst[i] = reference(arr_[i]).load(order);
+    }
+
+    // Stores src into the first src.size() elements.
+    void store(array_ref<T const> src, std::memory_order order = std::memory_order_relaxed) const noexcept
+    {
+        assert(src.size() <= size());
+        for (difference_type i = 0; i < src.size(); ++i)
+            reference(arr_[i]).store(src[i], order);
+    }
+
+    void fill(T value, std::memory_order order = std::memory_order_relaxed) const noexcept
+    {
+        for (difference_type i = 0; i < size(); ++i)
+            reference(arr_[i]).store(value, order);
+    }
+
+    // Adds value to the element at each index in idx, e.g. to update a shared
+    // histogram.
+    void fetch_add(array_ref<uint32_t const> idx, T value, std::memory_order order = std::memory_order_relaxed) const noexcept
+    {
+        for (uint32_t i : idx)
+            reference(arr_[i]).fetch_add(value, order);
+    }
+
+    // Returns [first, first + n)
+    atomic_array_ref slice(difference_type first, difference_type n) const noexcept {
+        return atomic_array_ref(arr_.slice(first, n));
+    }
+
+    atomic_array_ref take_front(difference_type n = 1) const noexcept {
+        return atomic_array_ref(arr_.take_front(n));
+    }
+
+    atomic_array_ref drop_front(difference_type n = 1) const noexcept {
+        return atomic_array_ref(arr_.drop_front(n));
+    }
+};
+
+#endif // __cpp_lib_atomic_ref >= 201806
+
+} // namespace cxx
+
+//------------------------------------------------------------------------------
+// Copyright 2017 A. Bolz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
@@ -0,0 +1,710 @@
+// Benchmarks for the kernels in this repository against the baselines they
+// are meant to replace. Build like Test.cc, but with optimizations, e.g.
+//
+//  g++ -std=c++20 -O2 -march=native -pthread Bench.cc -o bench
+//
+// Run without arguments to run all cases, or with a substring of the case
+// names to select some of them. Each line reports the fastest of a few runs,
+// and its speedup relative to the first variant of the case (the baseline).
+
+#include "ArrayRef.h"
+#include "AtomicArrayRef.h"
+#include "IndexedView.h"
+#include "Prefetch.h"
+#include "StreamCopy.h"
+#include "GatherWrite.h"
+#include "Tiling.h"
+#include "Views.h"
+#include "Compact.h"
+#include "Histogram.h"
+#include "Search.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Returns the fastest of reps runs of f, in milliseconds.
+template <typename F>
+double time_ms(F&& f, int reps = 5)
+{
+    double best = 1e300;
+    for (int r = 0; r < reps; ++r) {
+        auto const start = std::chrono::steady_clock::now();
+        f();
+        auto const stop = std::chrono::steady_clock::now();
+        double const ms = std::chrono::duration<double, std::milli>(stop - start).count();
+        if (ms < best)
+            best = ms;
+    }
+    return best;
+}
+
+// Keeps the compiler from removing the computation of x.
+template <typename T>
+void do_not_optimize(T const& x)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    static_cast<void>(*static_cast<char const volatile*>(static_cast<void const*>(&x)));
+#else
+    asm volatile("" : : "r,m"(x) : "memory");
+#endif
+}
+
+void print_header(char const* name)
+{
+    std::printf("\n%s\n", name);
+}
+
+void report(char const* variant, double ms, double baseline_ms)
+{
+    std::printf("  %-40s %10.3f ms %7.2fx\n", variant, ms, baseline_ms / ms);
+}
+
+int bench_threads()
+{
+    int const n = static_cast<int>(std::thread::hardware_concurrency());
+    return n > 1 ? n : 2;
+}
+
+// Runs f(t) on num_threads threads and waits for them.
+template <typename F>
+void run_threads(int num_threads, F f)
+{
+    std::vector<std::thread> threads;
+    threads.reserve(static_cast<std::size_t>(num_threads));
+    for (int t = 0; t < num_threads; ++t)
+        threads.emplace_back(f, t);
+    for (auto& th : threads)
+        th.join();
+}
+
+std::vector<uint32_t> random_indices(std::size_t n, uint32_t range, uint32_t seed = 1)
+{
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<uint32_t> dist(0, range - 1);
+    std::vector<uint32_t> idx(n);
+    for (auto& i : idx)
+        i = dist(gen);
+    return idx;
+}
+
+//------------------------------------------------------------------------------
+// atomic_array_ref
+//------------------------------------------------------------------------------
+
+void bench_atomic_histogram()
+{
+#if __cpp_lib_atomic_ref >= 201806
+    constexpr uint32_t bins = 4096;
+    constexpr std::size_t n = std::size_t{1} << 23;
+    auto const idx = random_indices(n, bins);
+
+    for (int num_threads : { 1, bench_threads() }) {
+        char title[96];
+        std::snprintf(title, sizeof(title), "atomic histogram, %u bins, %zu updates, %d thread(s)", bins, n, num_threads);
+        print_header(title);
+
+        auto const part = [&](int t) {
+            std::size_t const chunk = n / static_cast<std::size_t>(num_threads);
+            return cxx::array_ref<uint32_t const>(idx).slice(static_cast<std::ptrdiff_t>(chunk * t), static_cast<std::ptrdiff_t>(chunk));
+        };
+
+        std::vector<std::atomic<uint64_t>> atomics(bins);
+        double const base = time_ms([&] {
+            run_threads(num_threads, [&](int t) {
+                for (uint32_t i : part(t))
+                    atomics[i].fetch_add(1, std::memory_order_relaxed);
+            });
+        });
+        report("std::vector<std::atomic<uint64_t>>", base, base);
+
+        std::vector<uint64_t> plain(bins);
+        cxx::atomic_array_ref<uint64_t> counts(plain);
+        report("atomic_array_ref::fetch_add(i, 1)", time_ms([&] {
+            run_threads(num_threads, [&](int t) {
+                for (uint32_t i : part(t))
+                    counts.fetch_add(i, 1, std::memory_order_relaxed);
+            });
+        }), base);
+
+        report("atomic_array_ref::fetch_add(idx, 1)", time_ms([&] {
+            run_threads(num_threads, [&](int t) {
+                counts.fetch_add(part(t), 1);
+            });
+        }), base);
+
+        do_not_optimize(atomics[0]);
+        do_not_optimize(plain[0]);
+    }
+#else
+    print_header("atomic histogram: skipped, requires std::atomic_ref (C++20)");
+#endif
+}
+
+//------------------------------------------------------------------------------
+// stream_copy
+//------------------------------------------------------------------------------
+
+uint64_t sum_words(std::vector<uint64_t> const& v)
+{
+    uint64_t sum = 0;
+    for (uint64_t x : v)
+        sum += x;
+    return sum;
+}
+
+// Copies a buffer, then re-reads a working set of a quarter of the last level
+// cache which was hot before the copy. With non-temporal stores the copy does
+// not evict the working set. The copy sizes are the default stream_threshold
+// (half the cache), and twice the cache size. For the latter, glibc's memcpy
+// switches to non-temporal stores itself.
+void bench_stream_copy()
+{
+    std::ptrdiff_t const llc = cxx::detail::last_level_cache_size();
+    std::size_t const hot_words = static_cast<std::size_t>(llc / 4) / sizeof(uint64_t);
+    std::vector<uint64_t> hot(hot_words, 1);
+
+    for (std::size_t copy_bytes : { static_cast<std::size_t>(llc / 2), static_cast<std::size_t>(2 * llc) }) {
+        char title[96];
+        std::snprintf(title, sizeof(title), "stream_copy, %zu MiB copy, %zu MiB hot working set",
+                      copy_bytes >> 20, (hot_words * sizeof(uint64_t)) >> 20);
+        print_header(title);
+
+        std::vector<char> src(copy_bytes, 1);
+        std::vector<char> dst(copy_bytes, 0);
+
+        auto const run = [&](auto copy, double& copy_ms, double& reread_ms) {
+            copy_ms = reread_ms = 1e300;
+            for (int r = 0; r < 5; ++r) {
+                do_not_optimize(sum_words(hot));
+                copy_ms = std::min(copy_ms, time_ms(copy, 1));
+                reread_ms = std::min(reread_ms, time_ms([&] { do_not_optimize(sum_words(hot)); }, 1));
+            }
+            do_not_optimize(dst[copy_bytes / 2]);
+        };
+
+        double base_copy, base_reread;
+        run([&] { std::memcpy(dst.data(), src.data(), copy_bytes); }, base_copy, base_reread);
+
+        double copy, reread;
+        run([&] {
+            cxx::stream_copy(cxx::array_ref<char>(dst), cxx::array_ref<char const>(src), 0);
+        }, copy, reread);
+
+        report("std::memcpy: copy", base_copy, base_copy);
+        report("stream_copy: copy", copy, base_copy);
+        report("std::memcpy: re-read working set", base_reread, base_reread);
+        report("stream_copy: re-read working set", reread, base_reread);
+    }
+}
+
+//------------------------------------------------------------------------------
+// gather_writer
+//------------------------------------------------------------------------------
+
+// Writes messages of many small pieces to a temporary file, at offset 0 so
+// that the file does not grow. The baseline copies the pieces into one
+// reused buffer and writes it with a single pwrite.
+void bench_gather_write()
+{
+    constexpr int pieces = 1000;
+    constexpr int messages = 200;
+
+    std::FILE* const f = std::tmpfile();
+    if (f == nullptr) {
+        print_header("gather_writer: skipped, no temporary file");
+        return;
+    }
+    int const fd = fileno(f);
+
+    for (std::ptrdiff_t piece_size : { 16, 64, 512 }) {
+        char title[96];
+        std::snprintf(title, sizeof(title), "gather_writer, %d messages of %d pieces of %td bytes", messages, pieces, piece_size);
+        print_header(title);
+
+        std::vector<char> data(static_cast<std::size_t>(pieces * piece_size), 'x');
+        cxx::array_ref<char const> const all = data;
+
+        std::vector<char> buffer;
+        double const base = time_ms([&] {
+            for (int m = 0; m < messages; ++m) {
+                buffer.clear();
+                for (int i = 0; i < pieces; ++i) {
+                    auto const piece = all.slice(i * piece_size, piece_size);
+                    buffer.insert(buffer.end(), piece.begin(), piece.end());
+                }
+                if (::pwrite(fd, buffer.data(), buffer.size(), 0) != static_cast<ssize_t>(buffer.size()))
+                    std::perror("pwrite");
+            }
+        });
+        report("copy + pwrite", base, base);
+
+        cxx::gather_writer writer;
+        report("gather_writer::write_at", time_ms([&] {
+            for (int m = 0; m < messages; ++m) {
+                for (int i = 0; i < pieces; ++i)
+                    writer.add(all.slice(i * piece_size, piece_size));
+                if (writer.write_at(fd, 0) != 0)
+                    std::perror("writev");
+            }
+        }), base);
+    }
+
+    std::fclose(f);
+}
+
+//------------------------------------------------------------------------------
+// gather/scatter
+//------------------------------------------------------------------------------
+
+// Indices in runs of 64, each run within a random window of 256 elements.
+std::vector<uint32_t> clustered_indices(std::size_t n, uint32_t range, uint32_t seed = 1)
+{
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<uint32_t> base(0, range - 256);
+    std::uniform_int_distribution<uint32_t> offset(0, 255);
+    std::vector<uint32_t> idx(n);
+    uint32_t b = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        if (i % 64 == 0)
+            b = base(gen);
+        idx[i] = b + offset(gen);
+    }
+    return idx;
+}
+
+template <typename T>
+void bench_gather_type(char const* type_name)
+{
+    constexpr uint32_t range = uint32_t{1} << 25; // larger than the caches
+    constexpr std::size_t n = std::size_t{1} << 22;
+
+    std::vector<T> data(range, T(1));
+    std::vector<T> out(n);
+
+    for (bool clustered : { false, true }) {
+        auto const idx = clustered ? clustered_indices(n, range) : random_indices(n, range);
+        auto const count = static_cast<std::ptrdiff_t>(idx.size());
+
+        char title[96];
+        std::snprintf(title, sizeof(title), "gather/scatter %s, %zu %s indices into %u elements",
+                      type_name, n, clustered ? "clustered" : "random", range);
+        print_header(title);
+
+        double const base = time_ms([&] {
+            for (std::size_t i = 0; i < n; ++i)
+                out[i] = data[idx[i]];
+            do_not_optimize(out[n / 2]);
+        });
+        report("gather: plain loop", base, base);
+
+        report("gather: scalar + prefetch", time_ms([&] {
+            cxx::detail::gather_scalar<T>(out.data(), data.data(), idx.data(), 0, count);
+            do_not_optimize(out[n / 2]);
+        }), base);
+
+#if defined(__AVX2__)
+        report("gather: AVX2 gather", time_ms([&] {
+            auto const i = cxx::detail::gather_avx2<T>(out.data(), data.data(), idx.data(), count);
+            cxx::detail::gather_scalar<T>(out.data(), data.data(), idx.data(), i, count);
+            do_not_optimize(out[n / 2]);
+        }), base);
+#endif
+
+        double const scatter_base = time_ms([&] {
+            for (std::size_t i = 0; i < n; ++i)
+                data[idx[i]] = out[i];
+            do_not_optimize(data[range / 2]);
+        });
+        report("scatter: plain loop", scatter_base, scatter_base);
+
+        report("scatter: scalar + prefetch", time_ms([&] {
+            cxx::detail::scatter_scalar<T>(data.data(), out.data(), idx.data(), 0, count);
+            do_not_optimize(data[range / 2]);
+        }), scatter_base);
+    }
+}
+
+void bench_gather()
+{
+    bench_gather_type<uint32_t>("uint32_t");
+    bench_gather_type<uint64_t>("uint64_t");
+}
+
+//------------------------------------------------------------------------------
+// prefetch_range
+//------------------------------------------------------------------------------
+
+// Sums data[idx[i]] for random indices into an array larger than the caches,
+// iterating with prefetch_indexed_elements at increasing distances. Distance
+// 0 issues no prefetches and is the baseline.
+void bench_prefetch_distance()
+{
+    constexpr uint32_t range = uint32_t{1} << 25;
+    constexpr std::size_t n = std::size_t{1} << 22;
+
+    std::vector<uint64_t> data(range, 1);
+    auto const idx = random_indices(n, range);
+
+    char title[96];
+    std::snprintf(title, sizeof(title), "prefetch distance, sum of %zu random elements of %u", n, range);
+    print_header(title);
+
+    double base = 0;
+    for (std::ptrdiff_t distance : { 0, 4, 8, 16, 32, 64, 128 }) {
+        double const ms = time_ms([&] {
+            uint64_t sum = 0;
+            auto const r = cxx::prefetch_indexed_elements(cxx::array_ref<uint32_t const>(idx), cxx::array_ref<uint64_t const>(data), distance);
+            for (uint32_t i : r)
+                sum += data[i];
+            do_not_optimize(sum);
+        });
+        if (distance == 0)
+            base = ms;
+
+        char variant[40];
+        std::snprintf(variant, sizeof(variant), "distance %td", distance);
+        report(variant, ms, base);
+    }
+}
+
+//------------------------------------------------------------------------------
+// transpose
+//------------------------------------------------------------------------------
+
+// Transposes a square float matrix with the naive loop and with the blocked
+// transpose. The 4096 x 4096 case uses a power-of-two stride, for which the
+// naive loop's column writes also conflict in the cache sets.
+void bench_transpose()
+{
+    for (std::ptrdiff_t n : { 2000, 4096 }) {
+        char title[96];
+        std::snprintf(title, sizeof(title), "transpose, %td x %td floats", n, n);
+        print_header(title);
+
+        std::vector<float> a(static_cast<std::size_t>(n * n));
+        std::vector<float> b(static_cast<std::size_t>(n * n));
+        for (std::size_t i = 0; i < a.size(); ++i)
+            a[i] = static_cast<float>(i);
+
+        double const base = time_ms([&] {
+            for (std::ptrdiff_t r = 0; r < n; ++r) {
+                for (std::ptrdiff_t c = 0; c < n; ++c)
+                    b[static_cast<std::size_t>(c * n + r)] = a[static_cast<std::size_t>(r * n + c)];
+            }
+            do_not_optimize(b[1]);
+        });
+        report("naive loop", base, base);
+
+        cxx::matrix_ref<float const> src(cxx::array_ref<float const>(a), n, n, n);
+        cxx::matrix_ref<float> dst(cxx::array_ref<float>(b), n, n, n);
+        report("cxx::transpose", time_ms([&] {
+            cxx::transpose(src, dst);
+            do_not_optimize(b[1]);
+        }), base);
+    }
+}
+
+//------------------------------------------------------------------------------
+// views
+//------------------------------------------------------------------------------
+
+// "Scale, clamp, then sum" with one vector per step, with a hand-written
+// fused loop, and with composed transform views. The elements are integers:
+// a float sum is only vectorized if the compiler may reorder the additions.
+void bench_views()
+{
+    constexpr std::size_t n = std::size_t{1} << 24;
+
+    std::vector<int32_t> input(n);
+    std::mt19937 gen(1);
+    std::uniform_int_distribution<int32_t> dist(-1000, 1000);
+    for (auto& x : input)
+        x = dist(gen);
+    cxx::array_ref<int32_t const> const in = input;
+
+    auto const scale = [](int32_t x) { return x * 3; };
+    auto const clamp = [](int32_t x) { return std::min(std::max(x, 0), 1000); };
+    auto const positive = [](int32_t x) { return x > 0; };
+
+    char title[96];
+    std::snprintf(title, sizeof(title), "views, scale + clamp + sum of %zu int32_t", n);
+    print_header(title);
+
+    double const base = time_ms([&] {
+        std::vector<int32_t> scaled(n);
+        std::transform(in.begin(), in.end(), scaled.begin(), scale);
+        std::vector<int32_t> clamped(n);
+        std::transform(scaled.begin(), scaled.end(), clamped.begin(), clamp);
+        int64_t sum = 0;
+        for (int32_t x : clamped)
+            sum += x;
+        do_not_optimize(sum);
+    });
+    report("materializing", base, base);
+
+    report("hand-written loop", time_ms([&] {
+        int64_t sum = 0;
+        for (int32_t x : in)
+            sum += clamp(scale(x));
+        do_not_optimize(sum);
+    }), base);
+
+    report("transform views", time_ms([&] {
+        int64_t const sum = cxx::reduce(cxx::transform(cxx::transform(in, scale), clamp), int64_t{0});
+        do_not_optimize(sum);
+    }), base);
+
+    std::snprintf(title, sizeof(title), "views, sum of the positive elements of %zu int32_t", n);
+    print_header(title);
+
+    double const filter_base = time_ms([&] {
+        std::vector<int32_t> selected;
+        std::copy_if(in.begin(), in.end(), std::back_inserter(selected), positive);
+        int64_t sum = 0;
+        for (int32_t x : selected)
+            sum += x;
+        do_not_optimize(sum);
+    });
+    report("materializing", filter_base, filter_base);
+
+    report("hand-written loop", time_ms([&] {
+        int64_t sum = 0;
+        for (int32_t x : in) {
+            if (positive(x))
+                sum += x;
+        }
+        do_not_optimize(sum);
+    }), filter_base);
+
+    report("filter view", time_ms([&] {
+        int64_t const sum = cxx::reduce(cxx::filter(in, positive), int64_t{0});
+        do_not_optimize(sum);
+    }), filter_base);
+}
+
+//------------------------------------------------------------------------------
+// compact
+//------------------------------------------------------------------------------
+
+// Selects the elements of random int32_t data below a threshold, at several
+// selectivities, with a branching loop, with the branch-free scalar loop
+// (compact without AVX2) and with cxx::compact (AVX2 or AVX-512 if enabled).
+void bench_compact()
+{
+    constexpr std::size_t n = std::size_t{1} << 24;
+
+    auto const values = random_indices(n, 1000);
+    std::vector<int32_t> input(values.begin(), values.end());
+    std::vector<int32_t> out(n);
+    std::vector<uint32_t> out_idx(n);
+    cxx::array_ref<int32_t const> const in = input;
+
+    for (int32_t percent : { 1, 10, 50, 90, 99 }) {
+        int32_t const threshold = percent * 10;
+        auto const pred = [threshold](int32_t x) { return x < threshold; };
+
+        char title[96];
+        std::snprintf(title, sizeof(title), "compact, %zu int32_t, %d%% selected", n, percent);
+        print_header(title);
+
+        double const base = time_ms([&] {
+            std::size_t k = 0;
+            for (int32_t x : in) {
+                if (pred(x))
+                    out[k++] = x;
+            }
+            do_not_optimize(k);
+        });
+        report("branching loop", base, base);
+
+        report("branch-free loop", time_ms([&] {
+            std::size_t k = 0;
+            for (int32_t x : in) {
+                out[k] = x;
+                k += pred(x);
+            }
+            do_not_optimize(k);
+        }), base);
+
+        report("cxx::compact", time_ms([&] {
+            do_not_optimize(cxx::compact(in, cxx::array_ref<int32_t>(out), pred));
+        }), base);
+
+        report("cxx::compact_indices", time_ms([&] {
+            do_not_optimize(cxx::compact_indices(in, cxx::array_ref<uint32_t>(out_idx), pred));
+        }), base);
+    }
+}
+
+//------------------------------------------------------------------------------
+// histogram
+//------------------------------------------------------------------------------
+
+// Counts uniform and highly skewed (all but one in 16 elements equal) data
+// with a single histogram, with the sub-histogram kernel and in parallel.
+template <typename T>
+void bench_histogram_type(char const* type_name, std::ptrdiff_t bins)
+{
+    constexpr std::size_t n = std::size_t{1} << 24;
+
+    std::vector<uint32_t> hist(static_cast<std::size_t>(bins));
+    cxx::histogram_scratch scratch;
+
+    for (bool skewed : { false, true }) {
+        auto const values = random_indices(n, static_cast<uint32_t>(bins));
+        std::vector<T> input(n);
+        for (std::size_t i = 0; i < n; ++i)
+            input[i] = static_cast<T>(skewed && i % 16 != 0 ? 42 : values[i]);
+        cxx::array_ref<T const> const in = input;
+
+        char title[96];
+        std::snprintf(title, sizeof(title), "histogram, %zu %s, %s", n, type_name, skewed ? "skewed" : "uniform");
+        print_header(title);
+
+        double const base = time_ms([&] {
+            std::fill(hist.begin(), hist.end(), 0u);
+            for (T x : in)
+                ++hist[x];
+            do_not_optimize(hist[42]);
+        });
+        report("single histogram", base, base);
+
+        report("cxx::histogram", time_ms([&] {
+            std::fill(hist.begin(), hist.end(), 0u);
+            cxx::histogram(in, hist);
+            do_not_optimize(hist[42]);
+        }), base);
+
+        if constexpr (sizeof(T) == 2) {
+            report("cxx::histogram with scratch", time_ms([&] {
+                std::fill(hist.begin(), hist.end(), 0u);
+                cxx::histogram(in, hist, scratch);
+                do_not_optimize(hist[42]);
+            }), base);
+        }
+
+        report("cxx::parallel_histogram", time_ms([&] {
+            std::fill(hist.begin(), hist.end(), 0u);
+            cxx::parallel_histogram(in, hist, bench_threads());
+            do_not_optimize(hist[42]);
+        }), base);
+    }
+}
+
+void bench_histogram()
+{
+    bench_histogram_type<uint8_t>("uint8_t", 256);
+    bench_histogram_type<uint16_t>("uint16_t", 65536);
+}
+
+//------------------------------------------------------------------------------
+// search
+//------------------------------------------------------------------------------
+
+// Scans 64 MiB of log-like text (lowercase words, spaces and line breaks)
+// for a byte, a byte set and a substring, which only occur at the very end.
+void bench_search()
+{
+    constexpr std::size_t n = std::size_t{64} << 20;
+
+    std::string text(n, ' ');
+    std::mt19937 gen(1);
+    std::uniform_int_distribution<int> letter(0, 25);
+    std::uniform_int_distribution<int> word(2, 9);
+    for (std::size_t i = 0; i < n; ) {
+        std::size_t const len = static_cast<std::size_t>(word(gen));
+        for (std::size_t j = 0; j < len && i + j < n; ++j)
+            text[i + j] = static_cast<char>('a' + letter(gen));
+        i += len + 1;
+        if (i < n && i % 80 < 10)
+            text[i++] = '\n';
+    }
+    std::string_view const needle = "error: disk quota exceeded";
+    text.replace(n - needle.size() - 1, needle.size(), needle);
+    text[n - 1] = '#';
+    cxx::array_ref<char const> const t = text;
+
+    print_header("search, find a byte in 64 MiB of text");
+    double const find_base = time_ms([&] {
+        do_not_optimize(std::find(t.begin(), t.end(), '#'));
+    });
+    report("std::find", find_base, find_base);
+    report("std::memchr", time_ms([&] {
+        do_not_optimize(std::memchr(t.data(), '#', static_cast<std::size_t>(t.size())));
+    }), find_base);
+    report("cxx::find_byte", time_ms([&] {
+        do_not_optimize(cxx::find_byte(t, '#').data());
+    }), find_base);
+
+    std::string_view const set = "#@!{}";
+    print_header("search, find any of 5 bytes in 64 MiB of text");
+    double const any_base = time_ms([&] {
+        do_not_optimize(std::find_first_of(t.begin(), t.end(), set.begin(), set.end()));
+    });
+    report("std::find_first_of", any_base, any_base);
+    report("cxx::find_any_of", time_ms([&] {
+        do_not_optimize(cxx::find_any_of(t, cxx::array_ref<char const>(set)).data());
+    }), any_base);
+
+    print_header("search, find a 26-byte substring in 64 MiB of text");
+    double const search_base = time_ms([&] {
+        do_not_optimize(std::search(t.begin(), t.end(), needle.begin(), needle.end()));
+    });
+    report("std::search", search_base, search_base);
+    report("std::boyer_moore_horspool_searcher", time_ms([&] {
+        std::boyer_moore_horspool_searcher<char const*> const searcher(needle.data(), needle.data() + needle.size());
+        do_not_optimize(std::search(t.begin(), t.end(), searcher));
+    }), search_base);
+#if defined(__GLIBC__)
+    report("memmem", time_ms([&] {
+        do_not_optimize(::memmem(t.data(), static_cast<std::size_t>(t.size()), needle.data(), needle.size()));
+    }), search_base);
+#endif
+    report("cxx::search", time_ms([&] {
+        do_not_optimize(cxx::search(t, cxx::array_ref<char const>(needle)).data());
+    }), search_base);
+}
+
+struct bench_case
+{
+    char const* name;
+    void (*run)();
+};
+
+bench_case const cases[] = {
+    { "gather", bench_gather },
+    { "prefetch_distance", bench_prefetch_distance },
+    { "stream_copy", bench_stream_copy },
+    { "gather_write", bench_gather_write },
+    { "transpose", bench_transpose },
+    { "views", bench_views },
+    { "compact", bench_compact },
+    { "histogram", bench_histogram },
+    { "search", bench_search },
+    { "atomic_histogram", bench_atomic_histogram },
+};
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    char const* const filter = argc > 1 ? argv[1] : "";
+    for (auto const& c : cases) {
+        if (std::strstr(c.name, filter) != nullptr)
+            c.run();
+    }
+}
+
@@ -0,0 +1,346 @@
+// Distributed under the MIT license. See the end of the file for details.
+
+#pragma once
+
+#include "ArrayRef.h"
+
+#include <cstdint>
+#include <type_traits>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+namespace cxx {
+
+namespace detail {
+
+inline int popcount64(uint64_t w) noexcept
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    return static_cast<int>(__popcnt64(w));
+#else
+    return __builtin_popcountll(w);
+#endif
+}
+
+// w must not be zero.
+inline int ctz64(uint64_t w) noexcept
+{
+    assert(w != 0);
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long i;
+    _BitScanForward64(&i, w);
+    return static_cast<int>(i);
+#else
+    return __builtin_ctzll(w);
+#endif
+}
+
+// Returns a mask of the low n bits, 0 <= n < 64.
+constexpr uint64_t low_bits(std::ptrdiff_t n) noexcept
+{
+    return (uint64_t{1} << n) - 1;
+}
+
+} // namespace detail
+
+//------------------------------------------------------------------------------
+//
+//------------------------------------------------------------------------------
+
+// A bit set view of an array of 64-bit words. Bit i is bit i % 64 of word
+// i / 64. The bits of the last word at and beyond size() are ignored by the
+// queries, but may be overwritten by the bitwise operations below.
+template <typename WordT>
+class bit_array_ref
+{
+    static_assert(std::is_same<std::remove_const_t<WordT>, uint64_t>::value, "invalid template argument");
+
+public:
+    using difference_type = std::ptrdiff_t;
+
+private:
+    array_ref<WordT> words_;
+    difference_type size_ = 0;
+
+public:
+    constexpr bit_array_ref() noexcept = default;
+    constexpr bit_array_ref(bit_array_ref const&) noexcept = default;
+    constexpr bit_array_ref& operator=(bit_array_ref const&) noexcept = default;
+
+    // Uses the first size bits of words.
+    constexpr bit_array_ref(array_ref<WordT> words, difference_type size) noexcept
+        : words_(words.take_front(words_for(size)))
+        , size_(size)
+    {
+        assert(size_ >= 0);
+        assert(size_ <= words.size() * 64);
+    }
+
+    // Uses all bits of words.
+    constexpr explicit bit_array_ref(array_ref<WordT> words) noexcept
+        : words_(words)
+        , size_(words.size() * 64)
+    {
+    }
+
+    template <
+        typename OtherWordT,
+        typename = std::enable_if_t< is_array_convertible<OtherWordT, WordT>::value >
+    >
+    constexpr bit_array_ref(bit_array_ref<OtherWordT> const& rhs) noexcept
+        : words_(rhs.words())
+        , size_(rhs.size())
+    {
+    }
+
+    // Returns the number of words required to store n bits.
+    static constexpr difference_type words_for(difference_type n) noexcept {
+        return (n + 63) / 64;
+    }
+
+    constexpr array_ref<WordT> words() const noexcept {
+        return words_;
+    }
+
+    // Returns the number of bits.
+    constexpr difference_type size() const noexcept {
+        return size_;
+    }
+
+    constexpr bool empty() const noexcept {
+        return size_ == 0;
+    }
+
+    constexpr bool operator[](difference_type i) const noexcept {
+        return test(i);
+    }
+
+    constexpr bool test(difference_type i) const noexcept {
+        assert(i >= 0 && i < size_);
+        return (words_[i / 64] >> (i % 64)) & 1;
+    }
+
+    void set(difference_type i) const noexcept {
+        assert(i >= 0 && i < size_);
+        words_[i / 64] |= uint64_t{1} << (i % 64);
+    }
+
+    void reset(difference_type i) const noexcept {
+        assert(i >= 0 && i < size_);
+        words_[i / 64] &= ~(uint64_t{1} << (i % 64));
+    }
+
+    void set(difference_type i, bool value) const noexcept {
+        if (value)
+            set(i);
+        else
+            reset(i);
+    }
+
+    // Sets all bits to value.
+    void fill(bool value) const noexcept {
+        for (auto& w : words_)
+            w = value ? ~uint64_t{0} : 0;
+    }
+
+    // Returns the number of set bits.
+    difference_type count() const noexcept {
+        return rank(size_);
+    }
+
+    // Returns the number of set bits in [0, i).
+    difference_type rank(difference_type i) const noexcept
+    {
+        assert(i >= 0 && i <= size_);
+
+        difference_type const k = i / 64;
+        difference_type n = 0;
+        for (difference_type j = 0; j < k; ++j)
+            n += detail::popcount64(words_[j]);
+        if (i % 64 != 0)
+            n += detail::popcount64(words_[k] & detail::low_bits(i % 64));
+        return n;
+    }
+
+    // Returns the index of the first set bit at or after i, or size() if
+    // there is none.
+    difference_type find_next(difference_type i) const noexcept
+    {
+        assert(i >= 0 && i <= size_);
+        if (i == size_)
+            return size_;
+
+        difference_type k = i / 64;
+        uint64_t w = words_[k] & ~detail::low_bits(i % 64);
+        for (;;) {
+            if (w != 0) {
+                difference_type const r = k * 64 + detail::ctz64(w);
+                return r < size_ ? r : size_;
+            }
+            if (++k == words_.size())
+                return size_;
+            w = words_[k];
+        }
+    }
+
+    // Returns the index of the first set bit, or size() if there is none.
+    difference_type find_first() const noexcept {
+        return find_next(0);
+    }
+
+    // Calls f(i) for each set bit i in increasing order.
+    template <typename F>
+    void for_each_set(F f) const
+    {
+        for (difference_type k = 0; k < words_.size(); ++k) {
+            uint64_t w = words_[k];
+            if (k == words_.size() - 1 && size_ % 64 != 0)
+                w &= detail::low_bits(size_ % 64);
+            for ( ; w != 0; w &= w - 1)
+                f(k * 64 + detail::ctz64(w));
+        }
+    }
+};
+
+#if __cpp_deduction_guides >= 201606
+template <typename WordT>
+bit_array_ref(array_ref<WordT>, std::ptrdiff_t) -> bit_array_ref<WordT>;
+
+template <typename WordT>
+bit_array_ref(array_ref<WordT>) -> bit_array_ref<WordT>;
+#endif
+
+//------------------------------------------------------------------------------
+// Bitwise operations
+//------------------------------------------------------------------------------
+
+namespace detail {
+
+struct bit_and_op {
+    uint64_t operator()(uint64_t a, uint64_t b) const noexcept { return a & b; }
+#if defined(__AVX2__)
+    __m256i operator()(__m256i a, __m256i b) const noexcept { return _mm256_and_si256(a, b); }
+#endif
+};
+
+struct bit_or_op {
+    uint64_t operator()(uint64_t a, uint64_t b) const noexcept { return a | b; }
+#if defined(__AVX2__)
+    __m256i operator()(__m256i a, __m256i b) const noexcept { return _mm256_or_si256(a, b); }
+#endif
+};
+
+struct bit_xor_op {
+    uint64_t operator()(uint64_t a, uint64_t b) const noexcept { return a ^ b; }
+#if defined(__AVX2__)
+    __m256i operator()(__m256i a, __m256i b) const noexcept { return _mm256_xor_si256(a, b); }
+#endif
+};
+
+struct bit_andnot_op {
+    uint64_t operator()(uint64_t a, uint64_t b) const noexcept { return a & ~b; }
+#if defined(__AVX2__)
+    __m256i operator()(__m256i a, __m256i b) const noexcept { return _mm256_andnot_si256(b, a); }
+#endif
+};
+
+// dst may be the same as a or b.
+template <typename Op>
+void bit_apply(bit_array_ref<uint64_t> dst, bit_array_ref<uint64_t const> a, bit_array_ref<uint64_t const> b, Op op) noexcept
+{
+    assert(a.size() == dst.size());
+    assert(b.size() == dst.size());
+
+    uint64_t* const d = dst.words().data();
+    uint64_t const* const x = a.words().data();
+    uint64_t const* const y = b.words().data();
+    std::ptrdiff_t const n = dst.words().size();
+    std::ptrdiff_t i = 0;
+
+#if defined(__AVX2__)
+    for ( ; i + 4 <= n; i += 4) {
+        __m256i const u = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(x + i));
+        __m256i const v = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(y + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(d + i), op(u, v));
+    }
+#endif
+
+    for ( ; i < n; ++i)
+        d[i] = op(x[i], y[i]);
+}
+
+} // namespace detail
+
+// dst = a & b. All three must have the same size; dst may alias a or b.
+inline void bit_and(bit_array_ref<uint64_t> dst, bit_array_ref<uint64_t const> a, bit_array_ref<uint64_t const> b) noexcept {
+    detail::bit_apply(dst, a, b, detail::bit_and_op{});
+}
+
+// dst = a | b
+inline void bit_or(bit_array_ref<uint64_t> dst, bit_array_ref<uint64_t const> a, bit_array_ref<uint64_t const> b) noexcept {
+    detail::bit_apply(dst, a, b, detail::bit_or_op{});
+}
+
+// dst = a ^ b
+inline void bit_xor(bit_array_ref<uint64_t> dst, bit_array_ref<uint64_t const> a, bit_array_ref<uint64_t const> b) noexcept {
+    detail::bit_apply(dst, a, b, detail::bit_xor_op{});
+}
+
+// dst = a & ~b
+inline void bit_andnot(bit_array_ref<uint64_t> dst, bit_array_ref<uint64_t const> a, bit_array_ref<uint64_t const> b) noexcept {
+    detail::bit_apply(dst, a, b, detail::bit_andnot_op{});
+}
+
+//------------------------------------------------------------------------------
+// Conversion to and from index arrays
+//------------------------------------------------------------------------------
+
+// Stores the indices of the set bits of bits in increasing order to dst and
+// returns their number. dst must have at least bits.count() elements.
+inline std::ptrdiff_t to_indices(bit_array_ref<uint64_t const> bits, array_ref<uint32_t> dst) noexcept
+{
+    assert(bits.size() <= std::ptrdiff_t{UINT32_MAX} + 1);
+
+    std::ptrdiff_t n = 0;
+    bits.for_each_set([&](std::ptrdiff_t i) {
+        assert(n < dst.size());
+        dst[n++] = static_cast<uint32_t>(i);
+    });
+    return n;
+}
+
+// Sets exactly the bits of dst whose indices are in idx.
+inline void from_indices(array_ref<uint32_t const> idx, bit_array_ref<uint64_t> dst) noexcept
+{
+    dst.fill(false);
+    for (uint32_t i : idx)
+        dst.set(i);
+}
+
+} // namespace cxx
+
+//------------------------------------------------------------------------------
+// Copyright 2017 A. Bolz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
@@ -0,0 +1,262 @@
+// Distributed under the MIT license. See the end of the file for details.
+
+#pragma once
+
+#include "ArrayRef.h"
+
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#include <sys/types.h>
+#include <unistd.h>
+
+namespace cxx {
+
+namespace detail {
+
+struct pread_fn
+{
+    int fd = -1;
+
+    ssize_t operator()(void* buf, std::size_t count, off_t offset) const noexcept {
+        return ::pread(fd, buf, count, offset);
+    }
+};
+
+} // namespace detail
+
+// Reads a file as a sequence of blocks of T's using pread. Each block is
+// returned as an array_ref into a buffer owned by the reader, which stays
+// valid until the next call to next(). The buffer size need not be a multiple
+// of sizeof(T): records split across two blocks are reassembled at the start
+// of the next block. A trailing partial record at the end of the file is
+// dropped.
+//
+// With read_ahead, a background thread fills a second buffer while the
+// caller processes the current block.
+//
+// The file descriptor is not owned by the reader. Instead of a file
+// descriptor, any ReadFn can be used which behaves like pread, i.e. is called
+// as read(buf, count, offset) and returns the number of bytes read, 0 at the
+// end of the input, or -1 with errno set.
+template <typename T, typename ReadFn = detail::pread_fn>
+class block_reader
+{
+    static_assert(std::is_trivially_copyable<T>::value, "invalid template argument");
+
+public:
+    using element_type    = T const;
+    using difference_type = std::ptrdiff_t;
+
+    static constexpr std::size_t buffer_alignment = 4096;
+
+private:
+    struct buffer_deleter {
+        void operator()(char* p) const noexcept {
+            ::operator delete(p, std::align_val_t(buffer_alignment));
+        }
+    };
+
+    struct block {
+        std::unique_ptr<char, buffer_deleter> data;
+        difference_type count = 0;
+        int error = 0;
+        bool last = false;
+        bool filled = false;
+    };
+
+    ReadFn read_;
+    off_t offset_;
+    std::size_t block_bytes_;
+    block blocks_[2];
+
+    // Reader state
+    unsigned char carry_[sizeof(T)];
+    std::size_t carry_size_ = 0;
+
+    // Consumer state
+    int error_ = 0;
+    bool done_ = false;
+    int next_ = 0;
+    int held_ = -1;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stop_ = false;
+    std::thread thread_;
+
+    void fill(block& b) noexcept
+    {
+        char* const data = b.data.get();
+        std::size_t const capacity = block_bytes_;
+
+        std::memcpy(data, carry_, carry_size_);
+        std::size_t size = carry_size_;
+
+        b.error = 0;
+        b.last = false;
+        while (size < capacity) {
+            ssize_t const n = read_(data + size, capacity - size, offset_);
+            if (n < 0) {
+                if (errno == EINTR)
+                    continue;
+                b.error = errno;
+                b.last = true;
+                break;
+            }
+            if (n == 0) {
+                b.last = true;
+                break;
+            }
+            size += static_cast<std::size_t>(n);
+            offset_ += n;
+        }
+
+        b.count = static_cast<difference_type>(size / sizeof(T));
+        carry_size_ = size - static_cast<std::size_t>(b.count) * sizeof(T);
+        std::memcpy(carry_, data + static_cast<std::size_t>(b.count) * sizeof(T), carry_size_);
+    }
+
+    void read_ahead_loop() noexcept
+    {
+        for (int i = 0; ; i ^= 1) {
+            block& b = blocks_[i];
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [&] { return stop_ || (!b.filled && held_ != i); });
+                if (stop_)
+                    return;
+            }
+
+            fill(b);
+
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                b.filled = true;
+            }
+            cv_.notify_all();
+
+            if (b.last)
+                return;
+        }
+    }
+
+    static std::unique_ptr<char, buffer_deleter> allocate(std::size_t bytes)
+    {
+        return std::unique_ptr<char, buffer_deleter>(
+            static_cast<char*>(::operator new(bytes, std::align_val_t(buffer_alignment))));
+    }
+
+public:
+    // Reads from fd starting at offset, block_bytes bytes at a time.
+    // block_bytes must be at least sizeof(T).
+    block_reader(int fd, std::size_t block_bytes, bool read_ahead = false, off_t offset = 0)
+        : block_reader(ReadFn{fd}, block_bytes, read_ahead, offset)
+    {
+    }
+
+    block_reader(ReadFn read, std::size_t block_bytes, bool read_ahead = false, off_t offset = 0)
+        : read_(std::move(read))
+        , offset_(offset)
+        , block_bytes_(block_bytes)
+    {
+        assert(block_bytes_ >= sizeof(T));
+
+        blocks_[0].data = allocate(block_bytes_);
+        if (read_ahead) {
+            blocks_[1].data = allocate(block_bytes_);
+            thread_ = std::thread([this] { read_ahead_loop(); });
+        }
+    }
+
+    block_reader(block_reader const&) = delete;
+    block_reader& operator=(block_reader const&) = delete;
+
+    ~block_reader()
+    {
+        if (thread_.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                stop_ = true;
+            }
+            cv_.notify_all();
+            thread_.join();
+        }
+    }
+
+    // Returns the maximum number of records per block.
+    difference_type block_size() const noexcept {
+        return static_cast<difference_type>(block_bytes_ / sizeof(T));
+    }
+
+    // Returns 0, or the errno value of the read that ended the stream.
+    int error() const noexcept {
+        return error_;
+    }
+
+    // Returns the next block of records. An empty block signals the end of
+    // the file or an error. Invalidates the previously returned block.
+    // With read_ahead, throws std::system_error if the synchronization with
+    // the reader thread fails.
+    array_ref<T const> next()
+    {
+        if (!thread_.joinable()) {
+            if (done_)
+                return {};
+
+            block& b = blocks_[0];
+            fill(b);
+            error_ = b.error;
+            done_ = b.last;
+            return { reinterpret_cast<T const*>(b.data.get()), b.count };
+        }
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (held_ >= 0) {
+            blocks_[held_].filled = false;
+            held_ = -1;
+            cv_.notify_all();
+        }
+        if (done_)
+            return {};
+
+        block& b = blocks_[next_];
+        cv_.wait(lock, [&] { return b.filled; });
+        held_ = next_;
+        next_ ^= 1;
+
+        error_ = b.error;
+        done_ = b.last;
+        return { reinterpret_cast<T const*>(b.data.get()), b.count };
+    }
+};
+
+} // namespace cxx
+
+//------------------------------------------------------------------------------
+// Copyright 2017 A. Bolz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
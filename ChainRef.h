@@ -0,0 +1,285 @@
+// Distributed under the MIT license. See the end of the file for details.
+
+#pragma once
+
+#include "ArrayRef.h"
+#include "Hash.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+
+namespace cxx {
+
+//------------------------------------------------------------------------------
+//
+//------------------------------------------------------------------------------
+
+// Iterates over the elements of a list of segments. The iterator never points
+// into an empty segment, it is either dereferenceable or equal to end().
+template <typename T>
+class chain_iterator
+{
+    template <typename> friend class chain_iterator;
+
+public:
+    using iterator_category = std::bidirectional_iterator_tag;
+    using segment_type      = array_ref<T>;
+    using element_type      = typename segment_type::element_type;
+    using value_type        = typename segment_type::value_type;
+    using reference         = typename segment_type::reference;
+    using pointer           = typename segment_type::pointer;
+    using difference_type   = typename segment_type::difference_type;
+
+private:
+    segment_type const* first_ = nullptr;
+    segment_type const* seg_ = nullptr;
+    segment_type const* last_ = nullptr;
+    difference_type pos_ = 0;
+
+    constexpr void skip_empty() noexcept {
+        while (seg_ != last_ && seg_->empty())
+            ++seg_;
+    }
+
+public:
+    constexpr chain_iterator() noexcept = default;
+    constexpr chain_iterator(chain_iterator const&) noexcept = default;
+    constexpr chain_iterator& operator=(chain_iterator const&) noexcept = default;
+
+    constexpr chain_iterator(segment_type const* first, segment_type const* seg, segment_type const* last, difference_type pos = 0) noexcept
+        : first_(first)
+        , seg_(seg)
+        , last_(last)
+        , pos_(pos)
+    {
+        assert(first_ <= seg_ && seg_ <= last_);
+        if (pos_ == 0)
+            skip_empty();
+        assert(seg_ == last_ ? pos_ == 0 : pos_ < seg_->size());
+    }
+
+    // Returns the segment the iterator currently points into.
+    constexpr segment_type const* segment() const noexcept {
+        return seg_;
+    }
+
+    // Returns the position of the iterator within segment().
+    constexpr difference_type position() const noexcept {
+        return pos_;
+    }
+
+    constexpr reference operator*() const noexcept {
+        assert(seg_ != last_);
+        return (*seg_)[pos_];
+    }
+
+    constexpr pointer operator->() const noexcept {
+        assert(seg_ != last_);
+        return seg_->data() + pos_;
+    }
+
+    constexpr chain_iterator& operator++() noexcept {
+        assert(seg_ != last_);
+        if (++pos_ == seg_->size()) {
+            ++seg_;
+            pos_ = 0;
+            skip_empty();
+        }
+        return *this;
+    }
+
+    constexpr chain_iterator operator++(int) noexcept {
+        auto t = *this;
+        ++(*this);
+        return t;
+    }
+
+    constexpr chain_iterator& operator--() noexcept {
+        if (pos_ == 0) {
+            do {
+                assert(seg_ != first_);
+                --seg_;
+            } while (seg_->empty());
+            pos_ = seg_->size();
+        }
+        --pos_;
+        return *this;
+    }
+
+    constexpr chain_iterator operator--(int) noexcept {
+        auto t = *this;
+        --(*this);
+        return t;
+    }
+
+    constexpr friend bool operator==(chain_iterator lhs, chain_iterator rhs) noexcept {
+        assert(lhs.first_ == rhs.first_);
+        return lhs.seg_ == rhs.seg_ && lhs.pos_ == rhs.pos_;
+    }
+
+    constexpr friend bool operator!=(chain_iterator lhs, chain_iterator rhs) noexcept {
+        return !(lhs == rhs);
+    }
+};
+
+//------------------------------------------------------------------------------
+//
+//------------------------------------------------------------------------------
+
+// A view of the concatenation of a list of segments. The list itself is not
+// copied and must outlive the chain_ref.
+template <typename T>
+class chain_ref
+{
+public:
+    using iterator        = chain_iterator<T>;
+    using segment_type    = typename iterator::segment_type;
+    using element_type    = typename iterator::element_type;
+    using value_type      = typename iterator::value_type;
+    using reference       = typename iterator::reference;
+    using pointer         = typename iterator::pointer;
+    using difference_type = typename iterator::difference_type;
+
+private:
+    array_ref<segment_type const> segments_;
+
+public:
+    constexpr chain_ref() noexcept = default;
+    constexpr chain_ref(chain_ref const&) noexcept = default;
+    constexpr chain_ref& operator=(chain_ref const&) noexcept = default;
+
+    constexpr chain_ref(array_ref<segment_type const> segments) noexcept
+        : segments_(segments)
+    {
+    }
+
+    constexpr array_ref<segment_type const> segments() const noexcept {
+        return segments_;
+    }
+
+    // Returns the total number of elements. O(number of segments).
+    constexpr difference_type size() const noexcept {
+        difference_type n = 0;
+        for (auto const& s : segments_)
+            n += s.size();
+        return n;
+    }
+
+    constexpr bool empty() const noexcept {
+        for (auto const& s : segments_) {
+            if (!s.empty())
+                return false;
+        }
+        return true;
+    }
+
+    constexpr iterator begin() const noexcept {
+        auto const first = segments_.data();
+        return iterator { first, first, first + segments_.size() };
+    }
+
+    constexpr iterator end() const noexcept {
+        auto const first = segments_.data();
+        return iterator { first, first + segments_.size(), first + segments_.size() };
+    }
+};
+
+#if __cpp_deduction_guides >= 201606
+
+template <typename T>
+chain_ref(array_ref<array_ref<T> const>)
+    -> chain_ref<T>;
+
+#endif // __cpp_deduction_guides >= 201606
+
+//------------------------------------------------------------------------------
+// Segment-aware algorithms
+//------------------------------------------------------------------------------
+
+// Copies the elements of src into the front of dst. Returns the remaining
+// part of dst.
+template <typename T>
+array_ref<std::remove_const_t<T>> copy(chain_ref<T> src, array_ref<std::remove_const_t<T>> dst)
+{
+    assert(dst.size() >= src.size());
+
+    auto out = dst.data();
+    for (auto const& s : src.segments())
+        out = std::copy(s.data(), s.data() + s.size(), out);
+
+    return dst.drop_front(out - dst.data());
+}
+
+// Returns an iterator to the first element equal to value, or end().
+template <typename T>
+chain_iterator<T> find(chain_ref<T> src, typename chain_ref<T>::value_type const& value)
+{
+    auto const segments = src.segments();
+    auto const first = segments.data();
+    auto const last = first + segments.size();
+
+    for (auto seg = first; seg != last; ++seg) {
+        auto const p = std::find(seg->data(), seg->data() + seg->size(), value);
+        if (p != seg->data() + seg->size())
+            return chain_iterator<T>(first, seg, last, p - seg->data());
+    }
+
+    return src.end();
+}
+
+// Left fold of the elements with op, starting with init.
+template <typename T, typename Acc, typename BinaryOp>
+Acc reduce(chain_ref<T> src, Acc init, BinaryOp op)
+{
+    for (auto const& s : src.segments()) {
+        auto const p = s.data();
+        auto const n = s.size();
+        for (typename chain_ref<T>::difference_type i = 0; i < n; ++i)
+            init = op(init, p[i]);
+    }
+    return init;
+}
+
+template <typename T, typename Acc>
+Acc reduce(chain_ref<T> src, Acc init)
+{
+    return cxx::reduce(src, init, [](Acc const& x, typename chain_ref<T>::value_type const& y) { return x + y; });
+}
+
+// Returns hash_contents of the concatenated segments. The result does not
+// depend on how the elements are split into segments.
+template <typename T>
+uint64_t hash(chain_ref<T> src, uint64_t seed = 0) noexcept
+{
+    static_assert(std::is_trivially_copyable<std::remove_const_t<T>>::value, "invalid template argument");
+
+    hash_state h(seed);
+    for (auto const& s : src.segments())
+        h.update(s);
+    return h.digest();
+}
+
+} // namespace cxx
+
+//------------------------------------------------------------------------------
+// Copyright 2017 A. Bolz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
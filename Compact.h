@@ -0,0 +1,168 @@
+// Distributed under the MIT license. See the end of the file for details.
+
+#pragma once
+
+#include "ArrayRef.h"
+
+#include <cstdint>
+#include <type_traits>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+#if defined(__AVX2__) && defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+namespace cxx {
+
+namespace detail {
+
+// Returns bit j set iff pred(p[j]), for j in [0, 8).
+template <typename T, typename Pred>
+unsigned compact_mask8(T const* p, Pred& pred)
+{
+    unsigned m = 0;
+    for (int j = 0; j < 8; ++j)
+        m |= static_cast<unsigned>(static_cast<bool>(pred(p[j]))) << j;
+    return m;
+}
+
+#if defined(__AVX2__)
+// For each 8-bit mask, the indices of the set bits, one per byte, packed to
+// the front.
+struct compact_table
+{
+    uint64_t perm[256] = {};
+
+    constexpr compact_table() noexcept
+    {
+        for (unsigned m = 0; m < 256; ++m) {
+            uint64_t v = 0;
+            int k = 0;
+            for (unsigned j = 0; j < 8; ++j) {
+                if (m & (1u << j))
+                    v |= uint64_t{j} << (8 * k++);
+            }
+            perm[m] = v;
+        }
+    }
+};
+
+inline constexpr compact_table compact_perm {};
+
+// Moves the lanes of x selected by m to the front.
+inline __m256i compact8(__m256i x, unsigned m) noexcept
+{
+#if defined(__AVX512VL__)
+    return _mm256_maskz_compress_epi32(static_cast<__mmask8>(m), x);
+#else
+    __m256i const idx = _mm256_cvtepu8_epi32(_mm_cvtsi64_si128(static_cast<long long>(compact_perm.perm[m])));
+    return _mm256_permutevar8x32_epi32(x, idx);
+#endif
+}
+
+inline int popcount8(unsigned m) noexcept
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    return static_cast<int>(__popcnt(m));
+#else
+    return __builtin_popcount(m);
+#endif
+}
+#endif
+
+} // namespace detail
+
+// Copies the elements x of src for which pred(x) is true to the front of dst
+// and returns their number.
+//
+// The loop has no data-dependent branches: every element is stored and the
+// output position only advances for selected ones. For 4-byte trivially
+// copyable types, blocks of 8 elements are compacted with a single AVX2
+// permute (or AVX-512 compress). In both cases elements past the returned
+// count may be overwritten, so dst must be at least as large as src.
+template <typename T, typename Pred>
+std::ptrdiff_t compact(array_ref<std::add_const_t<T>> src, array_ref<T> dst, Pred pred)
+{
+    assert(dst.size() >= src.size());
+
+    T const* const s = src.data();
+    T* const d = dst.data();
+    std::ptrdiff_t const n = src.size();
+    std::ptrdiff_t i = 0;
+    std::ptrdiff_t k = 0;
+
+#if defined(__AVX2__)
+    if constexpr (sizeof(T) == 4 && std::is_trivially_copyable<T>::value) {
+        for ( ; i + 8 <= n; i += 8) {
+            unsigned const m = detail::compact_mask8(s + i, pred);
+            __m256i const x = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(s + i));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(d + k), detail::compact8(x, m));
+            k += detail::popcount8(m);
+        }
+    }
+#endif
+
+    for ( ; i < n; ++i) {
+        d[k] = s[i];
+        k += static_cast<bool>(pred(s[i]));
+    }
+    return k;
+}
+
+// Stores the indices i of the elements of src for which pred(src[i]) is true
+// to the front of dst and returns their number. As with compact, dst must be
+// at least as large as src.
+template <typename T, typename Pred>
+std::ptrdiff_t compact_indices(array_ref<T> src, array_ref<uint32_t> dst, Pred pred)
+{
+    assert(dst.size() >= src.size());
+    assert(src.size() <= INT32_MAX);
+
+    auto const s = src.data();
+    uint32_t* const d = dst.data();
+    std::ptrdiff_t const n = src.size();
+    std::ptrdiff_t i = 0;
+    std::ptrdiff_t k = 0;
+
+#if defined(__AVX2__)
+    __m256i idx = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    __m256i const step = _mm256_set1_epi32(8);
+    for ( ; i + 8 <= n; i += 8) {
+        unsigned const m = detail::compact_mask8(s + i, pred);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(d + k), detail::compact8(idx, m));
+        k += detail::popcount8(m);
+        idx = _mm256_add_epi32(idx, step);
+    }
+#endif
+
+    for ( ; i < n; ++i) {
+        d[k] = static_cast<uint32_t>(i);
+        k += static_cast<bool>(pred(s[i]));
+    }
+    return k;
+}
+
+} // namespace cxx
+
+//------------------------------------------------------------------------------
+// Copyright 2017 A. Bolz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
@@ -0,0 +1,299 @@
+// Distributed under the MIT license. See the end of the file for details.
+
+#pragma once
+
+#include "ArrayRef.h"
+
+#include <charconv>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <system_error>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+#if defined(__AVX2__) && defined(__PCLMUL__)
+#include <wmmintrin.h>
+#endif
+#if defined(__AVX2__) && defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+namespace cxx {
+
+// Fields are separated by delimiter, rows by '\n'. A '\r' directly before the
+// '\n' is not part of the last field. Delimiters and newlines between quotes
+// do not separate anything. A final '\n' does not start another row.
+struct csv_options
+{
+    char delimiter = ',';
+    char quote = '"';
+};
+
+struct csv_counts
+{
+    std::ptrdiff_t fields;
+    std::ptrdiff_t rows;
+};
+
+namespace detail {
+
+// Returns bit i = x[0] ^ ... ^ x[i]. Applied to the mask of quote
+// characters this is the mask of the bytes inside quotes.
+inline uint64_t prefix_xor(uint64_t x) noexcept
+{
+#if defined(__AVX2__) && defined(__PCLMUL__)
+    __m128i const r = _mm_clmulepi64_si128(_mm_set_epi64x(0, static_cast<long long>(x)), _mm_set1_epi8(-1), 0);
+    return static_cast<uint64_t>(_mm_cvtsi128_si64(r));
+#else
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+    x ^= x << 32;
+    return x;
+#endif
+}
+
+#if defined(__AVX2__)
+// Returns the mask of bytes in p[0, 64) equal to c.
+inline uint64_t match64(unsigned char const* p, __m256i c) noexcept
+{
+    auto const lo = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<__m256i const*>(p)), c)));
+    auto const hi = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<__m256i const*>(p + 32)), c)));
+    return (uint64_t{hi} << 32) | lo;
+}
+
+// Returns the index of the lowest set bit. m must not be zero.
+inline int lowest_bit64(uint64_t m) noexcept
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long i;
+    _BitScanForward64(&i, m);
+    return static_cast<int>(i);
+#else
+    return __builtin_ctzll(m);
+#endif
+}
+#endif
+
+} // namespace detail
+
+// Splits text into fields and rows. Stores the offset of the end of each
+// field (the offset of its delimiter or newline, or text.size()) to
+// field_ends, and for each row the number of fields up to and including
+// that row to row_ends. Returns the total number of fields and rows; at most
+// field_ends.size() resp. row_ends.size() of them are stored, so call with
+// empty arrays first to size the outputs. text must be smaller than 4 GiB.
+//
+// With AVX2, quotes, delimiters and newlines are classified 64 bytes at a
+// time; the quoted regions follow from a prefix XOR of the quote mask.
+inline csv_counts csv_tokenize(array_ref<char const> text, array_ref<uint32_t> field_ends, array_ref<uint32_t> row_ends, csv_options options = {}) noexcept
+{
+    assert(text.size() < std::ptrdiff_t{UINT32_MAX});
+
+    auto const p = reinterpret_cast<unsigned char const*>(text.data());
+    std::ptrdiff_t const n = text.size();
+
+    csv_counts counts { 0, 0 };
+    bool row_open = false; // whether the current row has any bytes
+
+    auto const emit = [&](std::ptrdiff_t pos, bool newline) {
+        if (counts.fields < field_ends.size())
+            field_ends[counts.fields] = static_cast<uint32_t>(pos);
+        ++counts.fields;
+        if (newline) {
+            if (counts.rows < row_ends.size())
+                row_ends[counts.rows] = static_cast<uint32_t>(counts.fields);
+            ++counts.rows;
+        }
+        row_open = !newline;
+    };
+
+    std::ptrdiff_t i = 0;
+    uint64_t in_quote = 0; // all ones while inside quotes
+
+#if defined(__AVX2__)
+    __m256i const q = _mm256_set1_epi8(options.quote);
+    __m256i const d = _mm256_set1_epi8(options.delimiter);
+    __m256i const nl = _mm256_set1_epi8('\n');
+
+    for ( ; i + 64 <= n; i += 64) {
+        uint64_t const quoted = detail::prefix_xor(detail::match64(p + i, q)) ^ in_quote;
+        in_quote = static_cast<uint64_t>(static_cast<int64_t>(quoted) >> 63);
+
+        uint64_t const newlines = detail::match64(p + i, nl) & ~quoted;
+        uint64_t m = (detail::match64(p + i, d) & ~quoted) | newlines;
+        int k = -1;
+        for ( ; m != 0; m &= m - 1) {
+            k = detail::lowest_bit64(m);
+            emit(i + k, (newlines >> k) & 1);
+        }
+        // Bytes after the last separator belong to the next field.
+        if (k < 63)
+            row_open = true;
+    }
+#endif
+
+    auto const quote = static_cast<unsigned char>(options.quote);
+    auto const delimiter = static_cast<unsigned char>(options.delimiter);
+    for ( ; i < n; ++i) {
+        unsigned char const c = p[i];
+        if (c == quote) {
+            in_quote = ~in_quote;
+            row_open = true;
+        } else if (in_quote == 0 && c == delimiter) {
+            emit(i, false);
+        } else if (in_quote == 0 && c == '\n') {
+            emit(i, true);
+        } else {
+            row_open = true;
+        }
+    }
+
+    if (row_open)
+        emit(n, true);
+
+    return counts;
+}
+
+//------------------------------------------------------------------------------
+//
+//------------------------------------------------------------------------------
+
+// A table view of tokenized CSV text. The text and the arrays filled in by
+// csv_tokenize must outlive the table.
+class csv_table
+{
+    array_ref<char const> text_;
+    array_ref<uint32_t const> field_ends_;
+    array_ref<uint32_t const> row_ends_;
+    char quote_;
+
+public:
+    // field_ends and row_ends must have exactly the sizes returned by
+    // csv_tokenize.
+    csv_table(array_ref<char const> text, array_ref<uint32_t const> field_ends, array_ref<uint32_t const> row_ends, csv_options options = {}) noexcept
+        : text_(text)
+        , field_ends_(field_ends)
+        , row_ends_(row_ends)
+        , quote_(options.quote)
+    {
+    }
+
+    std::ptrdiff_t rows() const noexcept {
+        return row_ends_.size();
+    }
+
+    // Returns the number of fields in row r.
+    std::ptrdiff_t fields(std::ptrdiff_t r) const noexcept {
+        return row_end(r) - row_begin(r);
+    }
+
+    // Returns field c of row r, or an empty array if the row has fewer
+    // fields. Surrounding quotes are removed, but doubled quotes inside a
+    // quoted field are not unescaped.
+    array_ref<char const> field(std::ptrdiff_t r, std::ptrdiff_t c) const noexcept
+    {
+        std::ptrdiff_t const k = row_begin(r) + c;
+        if (c < 0 || k >= row_end(r))
+            return {};
+
+        std::ptrdiff_t first = k == 0 ? 0 : field_ends_[k - 1] + 1;
+        std::ptrdiff_t last = field_ends_[k];
+        if (k + 1 == row_end(r) && last < text_.size() && last > first && text_[last - 1] == '\r')
+            --last;
+        if (last - first >= 2 && text_[first] == quote_ && text_[last - 1] == quote_) {
+            ++first;
+            --last;
+        }
+        return text_.slice(first, last - first);
+    }
+
+private:
+    std::ptrdiff_t row_begin(std::ptrdiff_t r) const noexcept {
+        assert(r >= 0 && r < rows());
+        return r == 0 ? 0 : row_ends_[r - 1];
+    }
+
+    std::ptrdiff_t row_end(std::ptrdiff_t r) const noexcept {
+        assert(r >= 0 && r < rows());
+        return row_ends_[r];
+    }
+};
+
+namespace detail {
+
+inline bool parse_field(array_ref<char const> s, int64_t& value) noexcept
+{
+    auto const r = std::from_chars(s.data(), s.data() + s.size(), value);
+    return r.ec == std::errc() && r.ptr == s.data() + s.size();
+}
+
+inline bool parse_field(array_ref<char const> s, double& value) noexcept
+{
+#if __cpp_lib_to_chars >= 201611
+    auto const r = std::from_chars(s.data(), s.data() + s.size(), value);
+    return r.ec == std::errc() && r.ptr == s.data() + s.size();
+#else
+    char buf[64];
+    if (s.empty() || s.size() >= static_cast<std::ptrdiff_t>(sizeof(buf)))
+        return false;
+    std::memcpy(buf, s.data(), static_cast<std::size_t>(s.size()));
+    buf[s.size()] = '\0';
+    char* end;
+    value = std::strtod(buf, &end);
+    return end == buf + s.size();
+#endif
+}
+
+template <typename T>
+std::ptrdiff_t parse_column(csv_table const& table, std::ptrdiff_t col, std::ptrdiff_t first_row, array_ref<T> out) noexcept
+{
+    std::ptrdiff_t r = first_row;
+    for ( ; r < table.rows() && r - first_row < out.size(); ++r) {
+        if (col >= table.fields(r) || !parse_field(table.field(r, col), out[r - first_row]))
+            break;
+    }
+    return r - first_row;
+}
+
+} // namespace detail
+
+// Parses field col of the rows [first_row, first_row + out.size()) into out
+// and returns the number of rows parsed. Stops at the first field which is
+// missing or not a number in its entirety (no surrounding spaces).
+inline std::ptrdiff_t parse_column(csv_table const& table, std::ptrdiff_t col, std::ptrdiff_t first_row, array_ref<int64_t> out) noexcept
+{
+    return detail::parse_column(table, col, first_row, out);
+}
+
+inline std::ptrdiff_t parse_column(csv_table const& table, std::ptrdiff_t col, std::ptrdiff_t first_row, array_ref<double> out) noexcept
+{
+    return detail::parse_column(table, col, first_row, out);
+}
+
+} // namespace cxx
+
+//------------------------------------------------------------------------------
+// Copyright 2017 A. Bolz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
@@ -0,0 +1,203 @@
+// Distributed under the MIT license. See the end of the file for details.
+
+#pragma once
+
+#include "ArrayRef.h"
+
+#include <cerrno>
+#include <climits>
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace cxx {
+
+namespace detail {
+
+inline int iov_max() noexcept
+{
+#if defined(IOV_MAX)
+    return IOV_MAX;
+#else
+    long const n = sysconf(_SC_IOV_MAX);
+    return n > 0 ? static_cast<int>(n) : 16;
+#endif
+}
+
+// Removes the first n bytes from iov. Completely written entries are set to
+// zero length. Returns their number.
+inline std::ptrdiff_t consume_iov(array_ref<iovec> iov, std::size_t n) noexcept
+{
+    std::ptrdiff_t i = 0;
+    for ( ; i < iov.size() && n >= iov[i].iov_len; ++i) {
+        n -= iov[i].iov_len;
+        iov[i].iov_len = 0;
+    }
+
+    if (n > 0) {
+        assert(i < iov.size());
+        iov[i].iov_base = static_cast<char*>(iov[i].iov_base) + n;
+        iov[i].iov_len -= n;
+    }
+    return i;
+}
+
+template <typename WriteFn>
+int write_iov(array_ref<iovec> iov, WriteFn write) noexcept
+{
+    int const max = iov_max();
+
+    while (!iov.empty()) {
+        int const count = iov.size() < max ? static_cast<int>(iov.size()) : max;
+        ssize_t const n = write(iov.data(), count);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return errno;
+        }
+        std::ptrdiff_t const done = consume_iov(iov.take_front(count), static_cast<std::size_t>(n));
+        // Nothing written although the first entry is not empty, e.g. at a
+        // file size limit: retrying would not make progress.
+        if (n == 0 && done == 0)
+            return ENOSPC;
+        iov = iov.drop_front(done);
+    }
+    return 0;
+}
+
+} // namespace detail
+
+// Writes all of iov to fd using writev, retrying partial writes and splitting
+// the request into batches of at most IOV_MAX entries. The entries of iov are
+// updated as data is written, so on error iov describes the unwritten data.
+// Returns 0 or an errno value; ENOSPC if a call wrote nothing. fd must be in
+// blocking mode.
+inline int writev_all(int fd, array_ref<iovec> iov) noexcept
+{
+    return detail::write_iov(iov, [fd](iovec const* v, int n) {
+        return ::writev(fd, v, n);
+    });
+}
+
+// Like writev_all, but writes at the given file offset using pwritev.
+inline int pwritev_all(int fd, array_ref<iovec> iov, off_t offset) noexcept
+{
+    return detail::write_iov(iov, [fd, &offset](iovec const* v, int n) {
+        ssize_t const r = ::pwritev(fd, v, n, offset);
+        if (r > 0)
+            offset += r;
+        return r;
+    });
+}
+
+//------------------------------------------------------------------------------
+//
+//------------------------------------------------------------------------------
+
+// Collects pieces of an output message and writes them with a single writev
+// (per IOV_MAX pieces) instead of copying them into one buffer first. The
+// pieces are not copied and must stay valid until the message is written.
+class gather_writer
+{
+    std::vector<iovec> iov_;
+    std::ptrdiff_t size_ = 0;
+
+public:
+    gather_writer() = default;
+
+    // Returns the number of bytes not yet written.
+    std::ptrdiff_t size() const noexcept {
+        return size_;
+    }
+
+    bool empty() const noexcept {
+        return size_ == 0;
+    }
+
+    // Removes all pieces. The capacity of the iovec array is kept.
+    void clear() noexcept {
+        iov_.clear();
+        size_ = 0;
+    }
+
+    void add(array_ref<std::byte const> piece)
+    {
+        if (piece.empty())
+            return;
+
+        iovec v;
+        v.iov_base = const_cast<std::byte*>(piece.data());
+        v.iov_len = static_cast<std::size_t>(piece.size());
+        iov_.push_back(v);
+        size_ += piece.size();
+    }
+
+    template <typename T>
+    void add(array_ref<T> piece)
+    {
+        static_assert(std::is_trivially_copyable<std::remove_const_t<T>>::value, "invalid template argument");
+        add(as_bytes(piece));
+    }
+
+    // Writes all pieces to fd. On success the writer is cleared; on error
+    // the unwritten pieces are kept so that the write can be retried.
+    // Returns 0 or an errno value.
+    int write(int fd) noexcept
+    {
+        return finish(writev_all(fd, iov_));
+    }
+
+    // Like write, but writes at the given file offset. To retry after an
+    // error, pass the original offset plus the number of bytes written.
+    int write_at(int fd, off_t offset) noexcept
+    {
+        return finish(pwritev_all(fd, iov_, offset));
+    }
+
+private:
+    int finish(int error) noexcept
+    {
+        if (error == 0) {
+            clear();
+            return 0;
+        }
+
+        // Drop the pieces which have been written completely.
+        std::ptrdiff_t size = 0;
+        auto it = iov_.begin();
+        while (it != iov_.end() && it->iov_len == 0)
+            ++it;
+        iov_.erase(iov_.begin(), it);
+        for (auto const& v : iov_)
+            size += static_cast<std::ptrdiff_t>(v.iov_len);
+        size_ = size;
+        return error;
+    }
+};
+
+} // namespace cxx
+
+//------------------------------------------------------------------------------
+// Copyright 2017 A. Bolz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
@@ -0,0 +1,337 @@
+// Distributed under the MIT license. See the end of the file for details.
+
+#pragma once
+
+#include "ArrayRef.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#if defined(_MSC_VER) && defined(_M_X64) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+namespace cxx {
+
+// The hash functions in this file follow the construction of wyhash (final
+// version 4). They are fast and have good statistical quality, but are not
+// suitable where an adversary can choose the input.
+
+namespace detail {
+
+constexpr uint64_t hash_secret[4] = {
+    0xa0761d6478bd642full, 0xe7037ed1a0b428dbull, 0x8ebc6af09c88c6e3ull, 0x589965cc75374cc3ull,
+};
+
+constexpr uint64_t hash_secret_alt[4] = {
+    0x1d8e4e27c47d124full, 0x9e3779b97f4a7c15ull, 0xc2b2ae3d27d4eb4full, 0x27d4eb2f165667c5ull,
+};
+
+// Computes the 128-bit product a * b and returns its low and high halves in
+// a and b.
+inline void hash_mum(uint64_t& a, uint64_t& b) noexcept
+{
+#if defined(__SIZEOF_INT128__)
+    __extension__ typedef unsigned __int128 uint128;
+    uint128 const r = static_cast<uint128>(a) * b;
+    a = static_cast<uint64_t>(r);
+    b = static_cast<uint64_t>(r >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64) && !defined(__clang__)
+    a = _umul128(a, b, &b);
+#else
+    uint64_t const ha = a >> 32, hb = b >> 32, la = static_cast<uint32_t>(a), lb = static_cast<uint32_t>(b);
+    uint64_t const rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    uint64_t const t = rl + (rm0 << 32);
+    uint64_t const lo = t + (rm1 << 32);
+    uint64_t const c = (t < rl) + (lo < t);
+    a = lo;
+    b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+}
+
+inline uint64_t hash_mix(uint64_t a, uint64_t b) noexcept
+{
+    hash_mum(a, b);
+    return a ^ b;
+}
+
+inline uint64_t hash_r8(unsigned char const* p) noexcept
+{
+    uint64_t v;
+    std::memcpy(&v, p, 8);
+    return v;
+}
+
+inline uint64_t hash_r4(unsigned char const* p) noexcept
+{
+    uint32_t v;
+    std::memcpy(&v, p, 4);
+    return v;
+}
+
+inline uint64_t hash_r3(unsigned char const* p, std::size_t k) noexcept
+{
+    return (uint64_t{p[0]} << 16) | (uint64_t{p[k >> 1]} << 8) | p[k - 1];
+}
+
+// Hashes the last 1..48 bytes [p, p + i) of an input of length len > 16.
+// Requires that the 16 bytes before p are readable and are the input bytes
+// preceding p, if i < 16.
+inline uint64_t hash_tail(unsigned char const* p, std::size_t i, std::size_t len, uint64_t seed, uint64_t const* secret) noexcept
+{
+    while (i > 16) {
+        seed = hash_mix(hash_r8(p) ^ secret[1], hash_r8(p + 8) ^ seed);
+        i -= 16;
+        p += 16;
+    }
+
+    uint64_t a = hash_r8(p + i - 16) ^ secret[1];
+    uint64_t b = hash_r8(p + i - 8) ^ seed;
+    hash_mum(a, b);
+    return hash_mix(a ^ secret[0] ^ len, b ^ secret[1]);
+}
+
+inline uint64_t hash_short(unsigned char const* p, std::size_t len, uint64_t seed, uint64_t const* secret) noexcept
+{
+    assert(len <= 16);
+
+    uint64_t a = 0;
+    uint64_t b = 0;
+    if (len >= 4) {
+        std::size_t const k = (len >> 3) << 2;
+        a = (hash_r4(p) << 32) | hash_r4(p + k);
+        b = (hash_r4(p + len - 4) << 32) | hash_r4(p + len - 4 - k);
+    } else if (len > 0) {
+        a = hash_r3(p, len);
+    }
+
+    a ^= secret[1];
+    b ^= seed;
+    hash_mum(a, b);
+    return hash_mix(a ^ secret[0] ^ len, b ^ secret[1]);
+}
+
+struct hash_stripe_state
+{
+    uint64_t seed;
+    uint64_t see1;
+    uint64_t see2;
+
+    void update(unsigned char const* p, uint64_t const* secret) noexcept {
+        seed = hash_mix(hash_r8(p)      ^ secret[1], hash_r8(p +  8) ^ seed);
+        see1 = hash_mix(hash_r8(p + 16) ^ secret[2], hash_r8(p + 24) ^ see1);
+        see2 = hash_mix(hash_r8(p + 32) ^ secret[3], hash_r8(p + 40) ^ see2);
+    }
+};
+
+inline uint64_t hash_bytes(unsigned char const* p, std::size_t len, uint64_t seed, uint64_t const* secret) noexcept
+{
+    seed ^= hash_mix(seed ^ secret[0], secret[1]);
+
+    if (len <= 16)
+        return hash_short(p, len, seed, secret);
+
+    std::size_t i = len;
+    if (i > 48) {
+        hash_stripe_state s { seed, seed, seed };
+        do {
+            s.update(p, secret);
+            p += 48;
+            i -= 48;
+        } while (i > 48);
+        seed = s.seed ^ s.see1 ^ s.see2;
+    }
+
+    return hash_tail(p, i, len, seed, secret);
+}
+
+} // namespace detail
+
+struct hash128
+{
+    uint64_t lo;
+    uint64_t hi;
+
+    friend bool operator==(hash128 const& lhs, hash128 const& rhs) noexcept {
+        return lhs.lo == rhs.lo && lhs.hi == rhs.hi;
+    }
+
+    friend bool operator!=(hash128 const& lhs, hash128 const& rhs) noexcept {
+        return !(lhs == rhs);
+    }
+};
+
+// Returns a 64-bit hash of the bytes of bytes.
+inline uint64_t hash_bytes(array_ref<std::byte const> bytes, uint64_t seed = 0) noexcept
+{
+    auto const p = reinterpret_cast<unsigned char const*>(bytes.data());
+    return detail::hash_bytes(p, static_cast<std::size_t>(bytes.size()), seed, detail::hash_secret);
+}
+
+// Returns a 128-bit hash of bytes, built from two 64-bit hashes with
+// independent secrets. Costs about twice as much as hash_bytes.
+inline hash128 hash_bytes128(array_ref<std::byte const> bytes, uint64_t seed = 0) noexcept
+{
+    auto const p = reinterpret_cast<unsigned char const*>(bytes.data());
+    auto const n = static_cast<std::size_t>(bytes.size());
+    return { detail::hash_bytes(p, n, seed, detail::hash_secret),
+             detail::hash_bytes(p, n, seed, detail::hash_secret_alt) };
+}
+
+// Returns a hash of the object representations of the elements of arr.
+// Padding bytes are hashed too, so T should not have any.
+template <typename T>
+uint64_t hash_contents(array_ref<T> arr, uint64_t seed = 0) noexcept
+{
+    static_assert(std::is_trivially_copyable<std::remove_const_t<T>>::value, "invalid template argument");
+    return hash_bytes(as_bytes(arr), seed);
+}
+
+template <typename T>
+hash128 hash_contents128(array_ref<T> arr, uint64_t seed = 0) noexcept
+{
+    static_assert(std::is_trivially_copyable<std::remove_const_t<T>>::value, "invalid template argument");
+    return hash_bytes128(as_bytes(arr), seed);
+}
+
+//------------------------------------------------------------------------------
+// Streaming
+//------------------------------------------------------------------------------
+
+// Computes hash_bytes of an input which is passed in several chunks. The
+// result is the same as for the concatenated input, independent of how it is
+// split.
+class hash_state
+{
+    // buf_[0, 16) holds the last 16 input bytes before the pending bytes,
+    // buf_[16, 16 + pending_) the bytes not yet processed.
+    alignas(8) unsigned char buf_[16 + 48] = {};
+    std::size_t pending_ = 0;
+    std::size_t len_ = 0;
+    uint64_t seed_;
+    detail::hash_stripe_state stripes_;
+
+public:
+    explicit hash_state(uint64_t seed = 0) noexcept
+    {
+        seed_ = seed ^ detail::hash_mix(seed ^ detail::hash_secret[0], detail::hash_secret[1]);
+        stripes_ = { seed_, seed_, seed_ };
+    }
+
+    void update(array_ref<std::byte const> bytes) noexcept
+    {
+        auto p = reinterpret_cast<unsigned char const*>(bytes.data());
+        auto n = static_cast<std::size_t>(bytes.size());
+        if (n == 0)
+            return;
+
+        len_ += n;
+
+        // A stripe is only processed once it is known not to be the tail.
+        if (pending_ + n <= 48) {
+            std::memcpy(buf_ + 16 + pending_, p, n);
+            pending_ += n;
+            return;
+        }
+
+        if (pending_ > 0) {
+            std::size_t const k = 48 - pending_;
+            std::memcpy(buf_ + 16 + pending_, p, k);
+            p += k;
+            n -= k;
+            stripes_.update(buf_ + 16, detail::hash_secret);
+            pending_ = 0;
+            if (n <= 48) {
+                std::memcpy(buf_, buf_ + 48, 16);
+                std::memcpy(buf_ + 16, p, n);
+                pending_ = n;
+                return;
+            }
+        }
+
+        while (n > 48) {
+            stripes_.update(p, detail::hash_secret);
+            p += 48;
+            n -= 48;
+        }
+        std::memcpy(buf_, p - 16, 16);
+        std::memcpy(buf_ + 16, p, n);
+        pending_ = n;
+    }
+
+    template <typename T>
+    void update(array_ref<T> arr) noexcept
+    {
+        static_assert(std::is_trivially_copyable<std::remove_const_t<T>>::value, "invalid template argument");
+        update(as_bytes(arr));
+    }
+
+    // Returns the hash of all bytes passed to update so far.
+    uint64_t digest() const noexcept
+    {
+        if (len_ <= 16)
+            return detail::hash_short(buf_ + 16, len_, seed_, detail::hash_secret);
+
+        uint64_t seed = seed_;
+        if (len_ > 48)
+            seed = stripes_.seed ^ stripes_.see1 ^ stripes_.see2;
+
+        return detail::hash_tail(buf_ + 16, pending_, len_, seed, detail::hash_secret);
+    }
+};
+
+//------------------------------------------------------------------------------
+// Hashing array_ref keys by content
+//------------------------------------------------------------------------------
+
+// array_ref compares by identity. Use these to key unordered containers on
+// the contents of the referenced arrays instead, e.g.
+//
+//  std::unordered_map<array_ref<char const>, V, content_hash, content_equal>
+//
+// Both are transparent, so lookups can use any array_ref type.
+struct content_hash
+{
+    using is_transparent = void;
+
+    template <typename T>
+    std::size_t operator()(array_ref<T> arr) const noexcept {
+        return static_cast<std::size_t>(hash_contents(arr));
+    }
+};
+
+struct content_equal
+{
+    using is_transparent = void;
+
+    template <typename T, typename U>
+    bool operator()(array_ref<T> lhs, array_ref<U> rhs) const noexcept {
+        return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+    }
+};
+
+} // namespace cxx
+
+//------------------------------------------------------------------------------
+// Copyright 2017 A. Bolz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
@@ -0,0 +1,251 @@
+// Distributed under the MIT license. See the end of the file for details.
+
+#pragma once
+
+#include "ArrayRef.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace cxx {
+
+// Memory for the sub-histograms used to count inputs into many bins. Passing
+// the same histogram_scratch to repeated histogram calls allocates it once,
+// instead of once per call.
+class histogram_scratch
+{
+    std::vector<uint32_t> counts_;
+
+public:
+    histogram_scratch() = default;
+
+    // Returns n zeroed counters.
+    uint32_t* zeroed(std::ptrdiff_t n)
+    {
+        assert(n >= 0);
+        if (counts_.size() < static_cast<std::size_t>(n))
+            counts_.resize(static_cast<std::size_t>(n));
+        std::fill(counts_.begin(), counts_.begin() + n, 0u);
+        return counts_.data();
+    }
+};
+
+namespace detail {
+
+struct identity_bin
+{
+    template <typename T>
+    std::ptrdiff_t operator()(T x) const noexcept {
+        return static_cast<std::ptrdiff_t>(x);
+    }
+};
+
+// Counts into Ways interleaved sub-histograms in local (Ways * bins zeroed
+// entries), so that runs of equal values increment different counters and
+// do not wait for the previous store to complete. Then adds them to hist.
+template <int Ways, typename T, typename Map>
+void histogram_ways(T const* s, std::ptrdiff_t n, uint32_t* hist, std::ptrdiff_t bins, Map& map, uint32_t* local)
+{
+    auto const bin = [&](T const& x) {
+        auto const b = static_cast<std::ptrdiff_t>(map(x));
+        assert(b >= 0 && b < bins);
+        return b;
+    };
+
+    std::ptrdiff_t i = 0;
+    for ( ; i + Ways <= n; i += Ways) {
+        for (int j = 0; j < Ways; ++j)
+            ++local[j * bins + bin(s[i + j])];
+    }
+    for ( ; i < n; ++i)
+        ++local[bin(s[i])];
+
+    for (int j = 0; j < Ways; ++j) {
+        for (std::ptrdiff_t b = 0; b < bins; ++b)
+            hist[b] += local[j * bins + b];
+    }
+}
+
+template <typename T, typename Map>
+void histogram(T const* s, std::ptrdiff_t n, uint32_t* hist, std::ptrdiff_t bins, Map& map, histogram_scratch* scratch = nullptr)
+{
+    // Sub-histograms only pay off if they are small compared to the input
+    // and still fit into L1/L2. Without scratch memory, allocating them costs
+    // about as much as counting a few elements per bin.
+    if (bins <= 256) {
+        uint32_t local[4 * 256] = {};
+        histogram_ways<4>(s, n, hist, bins, map, local);
+    } else if (n < (scratch != nullptr ? 4 : 16) * bins || bins > 64 * 1024) {
+        for (std::ptrdiff_t i = 0; i < n; ++i) {
+            auto const b = static_cast<std::ptrdiff_t>(map(s[i]));
+            assert(b >= 0 && b < bins);
+            ++hist[b];
+        }
+    } else {
+        int const ways = bins <= 4 * 1024 ? 4 : 2;
+        std::vector<uint32_t> owned;
+        uint32_t* local;
+        if (scratch != nullptr) {
+            local = scratch->zeroed(ways * bins);
+        } else {
+            owned.resize(static_cast<std::size_t>(ways * bins));
+            local = owned.data();
+        }
+        if (ways == 4)
+            histogram_ways<4>(s, n, hist, bins, map, local);
+        else
+            histogram_ways<2>(s, n, hist, bins, map, local);
+    }
+}
+
+template <typename T, typename Map>
+void parallel_histogram(T const* s, std::ptrdiff_t n, uint32_t* hist, std::ptrdiff_t bins, Map& map, int num_threads)
+{
+    if (num_threads <= 0)
+        num_threads = static_cast<int>(std::thread::hardware_concurrency());
+
+    constexpr std::ptrdiff_t min_chunk = 256 * 1024;
+    if (n / min_chunk < num_threads)
+        num_threads = static_cast<int>(n / min_chunk);
+
+    if (num_threads <= 1) {
+        histogram(s, n, hist, bins, map);
+        return;
+    }
+
+    std::ptrdiff_t const chunk = (n + num_threads - 1) / num_threads;
+    auto const first = [&](int t) { return t * chunk < n ? t * chunk : n; };
+
+    // Each thread counts its part of the input into its own histogram. The
+    // histograms are then merged in parallel, each thread summing a range of
+    // bins. The calling thread handles part 0.
+    std::vector<uint32_t> parts(static_cast<std::size_t>(num_threads * bins));
+    std::vector<std::thread> threads;
+    threads.reserve(static_cast<std::size_t>(num_threads - 1));
+
+    auto const count = [&](int t) {
+        Map m = map;
+        histogram(s + first(t), first(t + 1) - first(t), parts.data() + t * bins, bins, m);
+    };
+    for (int t = 1; t < num_threads; ++t)
+        threads.emplace_back(count, t);
+    count(0);
+    for (auto& th : threads)
+        th.join();
+    threads.clear();
+
+    std::ptrdiff_t const bin_chunk = (bins + num_threads - 1) / num_threads;
+    auto const merge = [&](int t) {
+        std::ptrdiff_t const lo = t * bin_chunk < bins ? t * bin_chunk : bins;
+        std::ptrdiff_t const hi = lo + bin_chunk < bins ? lo + bin_chunk : bins;
+        for (int p = 0; p < num_threads; ++p) {
+            uint32_t const* const part = parts.data() + p * bins;
+            for (std::ptrdiff_t b = lo; b < hi; ++b)
+                hist[b] += part[b];
+        }
+    };
+    for (int t = 1; t < num_threads; ++t)
+        threads.emplace_back(merge, t);
+    merge(0);
+    for (auto& th : threads)
+        th.join();
+}
+
+} // namespace detail
+
+// Adds the number of occurrences of each value in src to hist. hist must have
+// at least 256 entries and is not cleared first, so it can be used to count
+// an input in several pieces.
+inline void histogram(array_ref<uint8_t const> src, array_ref<uint32_t> hist)
+{
+    assert(hist.size() >= 256);
+    detail::identity_bin map;
+    detail::histogram(src.data(), src.size(), hist.data(), 256, map);
+}
+
+// hist must have at least 65536 entries.
+inline void histogram(array_ref<uint16_t const> src, array_ref<uint32_t> hist)
+{
+    assert(hist.size() >= 65536);
+    detail::identity_bin map;
+    detail::histogram(src.data(), src.size(), hist.data(), 65536, map);
+}
+
+// Takes the sub-histograms from scratch. Use this to count many small inputs.
+inline void histogram(array_ref<uint16_t const> src, array_ref<uint32_t> hist, histogram_scratch& scratch)
+{
+    assert(hist.size() >= 65536);
+    detail::identity_bin map;
+    detail::histogram(src.data(), src.size(), hist.data(), 65536, map, &scratch);
+}
+
+// Increments hist[map(x)] for each element x of src. map must return a value
+// in [0, hist.size()).
+template <
+    typename T,
+    typename Map,
+    typename = std::enable_if_t< !std::is_same<std::decay_t<Map>, histogram_scratch>::value >
+>
+void histogram(array_ref<T> src, array_ref<uint32_t> hist, Map map)
+{
+    detail::histogram(src.data(), src.size(), hist.data(), hist.size(), map);
+}
+
+template <typename T, typename Map>
+void histogram(array_ref<T> src, array_ref<uint32_t> hist, Map map, histogram_scratch& scratch)
+{
+    detail::histogram(src.data(), src.size(), hist.data(), hist.size(), map, &scratch);
+}
+
+// Like histogram, but splits large inputs across num_threads threads
+// (0 = hardware concurrency).
+inline void parallel_histogram(array_ref<uint8_t const> src, array_ref<uint32_t> hist, int num_threads = 0)
+{
+    assert(hist.size() >= 256);
+    detail::identity_bin map;
+    detail::parallel_histogram(src.data(), src.size(), hist.data(), 256, map, num_threads);
+}
+
+inline void parallel_histogram(array_ref<uint16_t const> src, array_ref<uint32_t> hist, int num_threads = 0)
+{
+    assert(hist.size() >= 65536);
+    detail::identity_bin map;
+    detail::parallel_histogram(src.data(), src.size(), hist.data(), 65536, map, num_threads);
+}
+
+// map is copied into each thread.
+template <
+    typename T,
+    typename Map,
+    typename = std::enable_if_t< !std::is_arithmetic<Map>::value >
+>
+void parallel_histogram(array_ref<T> src, array_ref<uint32_t> hist, Map map, int num_threads = 0)
+{
+    detail::parallel_histogram(src.data(), src.size(), hist.data(), hist.size(), map, num_threads);
+}
+
+} // namespace cxx
+
+//------------------------------------------------------------------------------
+// Copyright 2017 A. Bolz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
@@ -0,0 +1,326 @@
+// Distributed under the MIT license. See the end of the file for details.
+
+#pragma once
+
+#include "ArrayRef.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <type_traits>
+#include <utility>
+
+#include <sys/mman.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
+
+namespace cxx {
+
+enum class page_kind {
+    normal,      // base pages
+    transparent, // base pages, with the kernel asked to use transparent huge pages
+    huge_2m,     // MAP_HUGETLB, 2 MiB
+    huge_1g,     // MAP_HUGETLB, 1 GiB
+};
+
+enum class numa_policy {
+    local,      // the kernel default: first touch
+    bind,       // allocate on huge_page_options::node only
+    interleave, // distribute the pages round-robin over all nodes
+};
+
+struct huge_page_options
+{
+    page_kind pages = page_kind::huge_2m;
+    numa_policy policy = numa_policy::local;
+    int node = 0;
+};
+
+namespace detail {
+
+constexpr std::size_t huge_page_size_2m = std::size_t{1} << 21;
+constexpr std::size_t huge_page_size_1g = std::size_t{1} << 30;
+
+#if defined(__linux__)
+#if !defined(MAP_HUGE_SHIFT)
+#define CXX_MAP_HUGE_SHIFT 26
+#else
+#define CXX_MAP_HUGE_SHIFT MAP_HUGE_SHIFT
+#endif
+constexpr int map_huge_2m = 21 << CXX_MAP_HUGE_SHIFT;
+constexpr int map_huge_1g = 30 << CXX_MAP_HUGE_SHIFT;
+#undef CXX_MAP_HUGE_SHIFT
+
+// From <numaif.h>, which is part of libnuma and may not be installed.
+constexpr int mpol_bind = 2;
+constexpr int mpol_interleave = 3;
+#endif
+
+constexpr std::size_t round_up(std::size_t n, std::size_t alignment) noexcept
+{
+    return (n + alignment - 1) / alignment * alignment;
+}
+
+struct page_mapping
+{
+    void* addr = nullptr;
+    std::size_t length = 0;
+    page_kind kind = page_kind::normal;
+    int error = 0;
+};
+
+inline void* map_anonymous(std::size_t length, int extra_flags) noexcept
+{
+    void* const p = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | extra_flags, -1, 0);
+    return p == MAP_FAILED ? nullptr : p;
+}
+
+// Maps at least bytes bytes of zeroed memory, trying the requested page kind
+// first and falling back to smaller pages.
+inline page_mapping map_pages(std::size_t bytes, page_kind kind) noexcept
+{
+    page_mapping m;
+
+#if defined(__linux__) && defined(MAP_HUGETLB)
+    if (kind == page_kind::huge_1g) {
+        m.length = round_up(bytes, huge_page_size_1g);
+        if ((m.addr = map_anonymous(m.length, MAP_HUGETLB | map_huge_1g)) != nullptr) {
+            m.kind = page_kind::huge_1g;
+            return m;
+        }
+        kind = page_kind::huge_2m;
+    }
+
+    if (kind == page_kind::huge_2m) {
+        m.length = round_up(bytes, huge_page_size_2m);
+        if ((m.addr = map_anonymous(m.length, MAP_HUGETLB | map_huge_2m)) != nullptr) {
+            m.kind = page_kind::huge_2m;
+            return m;
+        }
+        kind = page_kind::transparent;
+    }
+#else
+    if (kind == page_kind::huge_1g || kind == page_kind::huge_2m)
+        kind = page_kind::transparent;
+#endif
+
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    if (kind == page_kind::transparent) {
+        // Over-allocate so that the region can be aligned to 2 MiB, which
+        // transparent huge pages require.
+        std::size_t const length = round_up(bytes, huge_page_size_2m);
+        auto const raw = static_cast<char*>(map_anonymous(length + huge_page_size_2m, 0));
+        if (raw == nullptr) {
+            m.error = errno;
+            return m;
+        }
+
+        auto const base = reinterpret_cast<std::uintptr_t>(raw);
+        auto const aligned = reinterpret_cast<char*>(round_up(base, huge_page_size_2m));
+        std::size_t const head = static_cast<std::size_t>(aligned - raw);
+        if (head > 0)
+            ::munmap(raw, head);
+        if (huge_page_size_2m - head > 0)
+            ::munmap(aligned + length, huge_page_size_2m - head);
+
+        m.addr = aligned;
+        m.length = length;
+        m.kind = ::madvise(aligned, length, MADV_HUGEPAGE) == 0 ? page_kind::transparent : page_kind::normal;
+        return m;
+    }
+#endif
+
+    long const page_size = ::sysconf(_SC_PAGESIZE);
+    m.length = round_up(bytes, page_size > 0 ? static_cast<std::size_t>(page_size) : 4096);
+    if ((m.addr = map_anonymous(m.length, 0)) == nullptr)
+        m.error = errno;
+    m.kind = page_kind::normal;
+    return m;
+}
+
+} // namespace detail
+
+// Returns the number of NUMA nodes the kernel knows about (the largest online
+// node number plus one), or 1 if this can not be determined.
+inline int numa_node_count() noexcept
+{
+#if defined(__linux__)
+    std::FILE* const f = std::fopen("/sys/devices/system/node/online", "r");
+    if (f == nullptr)
+        return 1;
+
+    // The format is a list of ranges, e.g. "0-1,4".
+    int max_node = 0;
+    int x = 0;
+    while (std::fscanf(f, "%d", &x) == 1) {
+        if (x > max_node)
+            max_node = x;
+        int const c = std::fgetc(f);
+        if (c != ',' && c != '-')
+            break;
+    }
+    std::fclose(f);
+    return max_node + 1;
+#else
+    return 1;
+#endif
+}
+
+// Applies a NUMA memory policy to [addr, addr + length), which must be page
+// aligned and should not have been touched yet. Returns 0 or an errno value.
+// On single-node machines, or if mbind is not available, this does nothing.
+inline int numa_apply_policy(void* addr, std::size_t length, numa_policy policy, int node = 0) noexcept
+{
+    if (policy == numa_policy::local)
+        return 0;
+
+#if defined(__linux__) && defined(SYS_mbind)
+    int const nodes = numa_node_count();
+    if (nodes <= 1)
+        return 0;
+    if (nodes > 64 || node < 0 || node >= nodes)
+        return EINVAL;
+
+    unsigned long mask;
+    int mode;
+    if (policy == numa_policy::bind) {
+        mask = 1ul << node;
+        mode = detail::mpol_bind;
+    } else {
+        mask = nodes == 64 ? ~0ul : (1ul << nodes) - 1;
+        mode = detail::mpol_interleave;
+    }
+
+    // The kernel reads maxnode - 1 bits.
+    if (::syscall(SYS_mbind, addr, length, mode, &mask, 64ul + 1, 0u) != 0)
+        return errno;
+    return 0;
+#else
+    static_cast<void>(addr);
+    static_cast<void>(length);
+    static_cast<void>(node);
+    return 0;
+#endif
+}
+
+//------------------------------------------------------------------------------
+//
+//------------------------------------------------------------------------------
+
+// An array of n zero-initialized T's in memory mapped with huge pages.
+//
+// The requested page kind is tried first; if the kernel has no huge pages of
+// that size reserved, the array falls back to 2 MiB pages, then to
+// transparent huge pages (a 2 MiB aligned mapping with MADV_HUGEPAGE), then to
+// normal pages. pages() returns what was used. The NUMA policy is applied
+// before any page is touched, and ignored on single-node machines.
+template <typename T>
+class huge_array
+{
+    static_assert(std::is_trivial<T>::value, "invalid template argument");
+
+    array_ref<T> arr_;
+    detail::page_mapping mapping_;
+    int numa_error_ = 0;
+
+public:
+    huge_array() noexcept = default;
+
+    explicit huge_array(std::ptrdiff_t n, huge_page_options options = {}) noexcept
+    {
+        assert(n >= 0);
+        if (n == 0)
+            return;
+
+        mapping_ = detail::map_pages(static_cast<std::size_t>(n) * sizeof(T), options.pages);
+        if (mapping_.addr == nullptr)
+            return;
+
+        numa_error_ = numa_apply_policy(mapping_.addr, mapping_.length, options.policy, options.node);
+        arr_ = { static_cast<T*>(mapping_.addr), n };
+    }
+
+    huge_array(huge_array&& rhs) noexcept
+        : arr_(std::exchange(rhs.arr_, {}))
+        , mapping_(std::exchange(rhs.mapping_, {}))
+        , numa_error_(rhs.numa_error_)
+    {
+    }
+
+    huge_array& operator=(huge_array&& rhs) noexcept
+    {
+        huge_array(std::move(rhs)).swap(*this);
+        return *this;
+    }
+
+    ~huge_array()
+    {
+        if (mapping_.addr != nullptr)
+            ::munmap(mapping_.addr, mapping_.length);
+    }
+
+    void swap(huge_array& rhs) noexcept
+    {
+        std::swap(arr_, rhs.arr_);
+        std::swap(mapping_, rhs.mapping_);
+        std::swap(numa_error_, rhs.numa_error_);
+    }
+
+    array_ref<T> get() const noexcept {
+        return arr_;
+    }
+
+    T* data() const noexcept {
+        return arr_.data();
+    }
+
+    std::ptrdiff_t size() const noexcept {
+        return arr_.size();
+    }
+
+    bool empty() const noexcept {
+        return arr_.empty();
+    }
+
+    // Returns the kind of pages backing the array.
+    page_kind pages() const noexcept {
+        return mapping_.kind;
+    }
+
+    // Returns 0, or the errno value of the failed mmap. The array is empty in
+    // this case.
+    int error() const noexcept {
+        return mapping_.error;
+    }
+
+    // Returns 0, or the errno value if the NUMA policy could not be applied.
+    // The array is still usable in this case.
+    int numa_error() const noexcept {
+        return numa_error_;
+    }
+};
+
+} // namespace cxx
+
+//------------------------------------------------------------------------------
+// Copyright 2017 A. Bolz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
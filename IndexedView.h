@@ -0,0 +1,399 @@
+// Distributed under the MIT license. See the end of the file for details.
+
+#pragma once
+
+#include "ArrayRef.h"
+#include "Prefetch.h"
+
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace cxx {
+
+namespace detail {
+
+// Number of elements the scalar gather/scatter loops look ahead.
+constexpr std::ptrdiff_t indexed_prefetch_distance = 16;
+
+} // namespace detail
+
+//------------------------------------------------------------------------------
+//
+//------------------------------------------------------------------------------
+
+template <typename T>
+class indexed_iterator
+{
+    template <typename> friend class indexed_iterator;
+
+public:
+    using iterator_category = std::random_access_iterator_tag;
+    using element_type      = T;
+    using value_type        = std::remove_cv_t<element_type>;
+    using reference         = std::add_lvalue_reference_t<element_type>;
+    using pointer           = std::add_pointer_t<element_type>;
+    using difference_type   = std::ptrdiff_t;
+    using index_iterator    = array_iterator<uint32_t const*>;
+
+private:
+    pointer data_ = nullptr;
+    index_iterator idx_;
+
+public:
+    constexpr indexed_iterator() noexcept = default;
+    constexpr indexed_iterator(indexed_iterator const&) noexcept = default;
+    constexpr indexed_iterator& operator=(indexed_iterator const&) noexcept = default;
+
+    template <
+        typename U,
+        typename = std::enable_if_t< is_array_convertible<U, element_type>::value >
+    >
+    constexpr indexed_iterator(indexed_iterator<U> const& it) noexcept
+        : data_(it.data_)
+        , idx_(it.idx_)
+    {
+    }
+
+    constexpr indexed_iterator(pointer data, index_iterator idx) noexcept
+        : data_(data)
+        , idx_(idx)
+    {
+    }
+
+    // Returns the index of the current element into the underlying data.
+    constexpr uint32_t index() const noexcept {
+        return *idx_;
+    }
+
+    constexpr reference operator*() const noexcept {
+        assert(data_ != nullptr);
+        return data_[*idx_];
+    }
+
+    constexpr pointer operator->() const noexcept {
+        assert(data_ != nullptr);
+        return data_ + *idx_;
+    }
+
+    constexpr indexed_iterator& operator++() noexcept {
+        ++idx_;
+        return *this;
+    }
+
+    constexpr indexed_iterator operator++(int) noexcept {
+        auto t = *this;
+        ++(*this);
+        return t;
+    }
+
+    constexpr indexed_iterator& operator--() noexcept {
+        --idx_;
+        return *this;
+    }
+
+    constexpr indexed_iterator operator--(int) noexcept {
+        auto t = *this;
+        --(*this);
+        return t;
+    }
+
+    constexpr indexed_iterator& operator+=(difference_type n) noexcept {
+        idx_ += n;
+        return *this;
+    }
+
+    constexpr indexed_iterator operator+(difference_type n) const noexcept {
+        auto t = *this;
+        t += n;
+        return t;
+    }
+
+    constexpr friend indexed_iterator operator+(difference_type n, indexed_iterator it) noexcept {
+        return it + n;
+    }
+
+    constexpr indexed_iterator& operator-=(difference_type n) noexcept {
+        idx_ -= n;
+        return *this;
+    }
+
+    constexpr indexed_iterator operator-(difference_type n) const noexcept {
+        auto t = *this;
+        t -= n;
+        return t;
+    }
+
+    constexpr difference_type operator-(indexed_iterator rhs) const noexcept {
+        assert(data_ == rhs.data_);
+        return idx_ - rhs.idx_;
+    }
+
+    constexpr reference operator[](difference_type index) const noexcept {
+        assert(data_ != nullptr);
+        return data_[idx_[index]];
+    }
+
+    constexpr friend bool operator==(indexed_iterator lhs, indexed_iterator rhs) noexcept {
+        assert(lhs.data_ == rhs.data_);
+        return lhs.idx_ == rhs.idx_;
+    }
+
+    constexpr friend bool operator!=(indexed_iterator lhs, indexed_iterator rhs) noexcept {
+        return !(lhs == rhs);
+    }
+
+    constexpr friend bool operator<(indexed_iterator lhs, indexed_iterator rhs) noexcept {
+        assert(lhs.data_ == rhs.data_);
+        return lhs.idx_ < rhs.idx_;
+    }
+
+    constexpr friend bool operator>(indexed_iterator lhs, indexed_iterator rhs) noexcept {
+        return rhs < lhs;
+    }
+
+    constexpr friend bool operator<=(indexed_iterator lhs, indexed_iterator rhs) noexcept {
+        return !(rhs < lhs);
+    }
+
+    constexpr friend bool operator>=(indexed_iterator lhs, indexed_iterator rhs) noexcept {
+        return !(lhs < rhs);
+    }
+};
+
+//------------------------------------------------------------------------------
+//
+//------------------------------------------------------------------------------
+
+// A view of the elements data[idx[0]], data[idx[1]], ..., data[idx[n - 1]].
+template <typename T>
+class indexed_view
+{
+public:
+    using iterator        = indexed_iterator<T>;
+    using element_type    = typename iterator::element_type;
+    using value_type      = typename iterator::value_type;
+    using reference       = typename iterator::reference;
+    using pointer         = typename iterator::pointer;
+    using difference_type = typename iterator::difference_type;
+    using index_type      = uint32_t;
+
+private:
+    array_ref<element_type> data_;
+    array_ref<index_type const> idx_;
+
+public:
+    constexpr indexed_view() noexcept = default;
+    constexpr indexed_view(indexed_view const&) noexcept = default;
+    constexpr indexed_view& operator=(indexed_view const&) noexcept = default;
+
+    constexpr indexed_view(array_ref<element_type> data, array_ref<index_type const> idx) noexcept
+        : data_(data)
+        , idx_(idx)
+    {
+    }
+
+    template <
+        typename U,
+        typename = std::enable_if_t< is_array_convertible<U, element_type>::value >
+    >
+    constexpr indexed_view(indexed_view<U> const& rhs) noexcept
+        : data_(rhs.data())
+        , idx_(rhs.indices())
+    {
+    }
+
+    constexpr array_ref<element_type> data() const noexcept {
+        return data_;
+    }
+
+    constexpr array_ref<index_type const> indices() const noexcept {
+        return idx_;
+    }
+
+    constexpr reference operator[](difference_type index) const noexcept {
+        assert(idx_[index] < static_cast<uint64_t>(data_.size()));
+        return data_[idx_[index]];
+    }
+
+    constexpr difference_type size() const noexcept {
+        return idx_.size();
+    }
+
+    constexpr bool empty() const noexcept {
+        return idx_.empty();
+    }
+
+    constexpr iterator begin() const noexcept {
+        return iterator { data_.data(), idx_.begin() };
+    }
+
+    constexpr iterator end() const noexcept {
+        return iterator { data_.data(), idx_.end() };
+    }
+
+    constexpr indexed_view take_front(difference_type n = 1) const noexcept {
+        return { data_, idx_.take_front(n) };
+    }
+
+    constexpr indexed_view take_back(difference_type n = 1) const noexcept {
+        return { data_, idx_.take_back(n) };
+    }
+
+    constexpr indexed_view drop_front(difference_type n = 1) const noexcept {
+        return { data_, idx_.drop_front(n) };
+    }
+
+    constexpr indexed_view drop_back(difference_type n = 1) const noexcept {
+        return { data_, idx_.drop_back(n) };
+    }
+
+    constexpr indexed_view slice(difference_type first, difference_type n) const noexcept {
+        return { data_, idx_.slice(first, n) };
+    }
+
+    constexpr indexed_view slice(difference_type first) const noexcept {
+        return { data_, idx_.slice(first) };
+    }
+};
+
+//------------------------------------------------------------------------------
+//
+//------------------------------------------------------------------------------
+
+namespace detail {
+
+template <typename T>
+void gather_scalar(T* dst, T const* src, uint32_t const* idx, std::ptrdiff_t first, std::ptrdiff_t n) noexcept
+{
+    constexpr std::ptrdiff_t D = indexed_prefetch_distance;
+
+    std::ptrdiff_t i = first;
+    for ( ; i + D < n; ++i) {
+        prefetch_read(src + idx[i + D]);
+        dst[i] = src[idx[i]];
+    }
+    for ( ; i < n; ++i) {
+        dst[i] = src[idx[i]];
+    }
+}
+
+template <typename T>
+void scatter_scalar(T* dst, T const* src, uint32_t const* idx, std::ptrdiff_t first, std::ptrdiff_t n) noexcept
+{
+    constexpr std::ptrdiff_t D = indexed_prefetch_distance;
+
+    std::ptrdiff_t i = first;
+    for ( ; i + D < n; ++i) {
+        prefetch_write(dst + idx[i + D]);
+        dst[idx[i]] = src[i];
+    }
+    for ( ; i < n; ++i) {
+        dst[idx[i]] = src[i];
+    }
+}
+
+#if defined(__AVX2__)
+// The hardware gathers sign-extend 32-bit indices, so they can only be used
+// if every index fits into an int32_t.
+template <typename T>
+std::ptrdiff_t gather_avx2(T* dst, T const* src, uint32_t const* idx, std::ptrdiff_t n) noexcept
+{
+    std::ptrdiff_t i = 0;
+    if (sizeof(T) == 4) {
+        auto const base = reinterpret_cast<int const*>(src);
+        for ( ; i + 8 <= n; i += 8) {
+            __m256i const vi = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(idx + i));
+            __m256i const v = _mm256_i32gather_epi32(base, vi, 4);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), v);
+        }
+    } else if (sizeof(T) == 8) {
+        auto const base = reinterpret_cast<long long const*>(src);
+        for ( ; i + 4 <= n; i += 4) {
+            __m128i const vi = _mm_loadu_si128(reinterpret_cast<__m128i const*>(idx + i));
+            __m256i const v = _mm256_i32gather_epi64(base, vi, 8);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), v);
+        }
+    }
+    return i;
+}
+#endif
+
+} // namespace detail
+
+// dst[i] = src[idx[i]] for all i in [0, idx.size())
+template <typename T>
+void gather(array_ref<std::remove_const_t<T>> dst, array_ref<T> src, array_ref<uint32_t const> idx) noexcept
+{
+    using V = std::remove_const_t<T>;
+
+    assert(dst.size() >= idx.size());
+#ifndef NDEBUG
+    for (auto i : idx)
+        assert(i < static_cast<uint64_t>(src.size()));
+#endif
+
+    std::ptrdiff_t i = 0;
+#if defined(__AVX2__)
+    if (std::is_trivially_copyable<V>::value && (sizeof(V) == 4 || sizeof(V) == 8) && src.size() <= INT32_MAX) {
+        i = detail::gather_avx2<V>(dst.data(), src.data(), idx.data(), idx.size());
+    }
+#endif
+    detail::gather_scalar<V>(dst.data(), src.data(), idx.data(), i, idx.size());
+}
+
+// dst[i] = src[i] for all i in [0, src.size())
+template <typename T>
+void gather(array_ref<std::remove_const_t<T>> dst, indexed_view<T> src) noexcept
+{
+    gather<T>(dst, src.data(), src.indices());
+}
+
+// dst[idx[i]] = src[i] for all i in [0, idx.size())
+template <typename T>
+void scatter(array_ref<T> dst, array_ref<std::add_const_t<T>> src, array_ref<uint32_t const> idx) noexcept
+{
+    static_assert(!std::is_const<T>::value, "invalid template argument");
+
+    assert(src.size() >= idx.size());
+#ifndef NDEBUG
+    for (auto i : idx)
+        assert(i < static_cast<uint64_t>(dst.size()));
+#endif
+
+    detail::scatter_scalar<T>(dst.data(), src.data(), idx.data(), 0, idx.size());
+}
+
+// dst[i] = src[i] for all i in [0, dst.size())
+template <typename T>
+void scatter(indexed_view<T> dst, array_ref<std::add_const_t<T>> src) noexcept
+{
+    scatter<T>(dst.data(), src, dst.indices());
+}
+
+} // namespace cxx
+
+//------------------------------------------------------------------------------
+// Copyright 2017 A. Bolz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
@@ -0,0 +1,192 @@
+// Distributed under the MIT license. See the end of the file for details.
+
+#pragma once
+
+#include "ArrayRef.h"
+#include "Search.h"
+
+#include <cstdint>
+#include <iterator>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace cxx {
+
+// Lines are separated by '\n'. A '\r' directly before the '\n' is not part of
+// the line. A final '\n' does not start another (empty) line.
+
+// Iterates over the lines of a text. The lines are not copied; each one is
+// returned as an array_ref into the text.
+class line_iterator
+{
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type        = array_ref<char const>;
+    using reference         = array_ref<char const>;
+    using pointer           = void;
+    using difference_type   = std::ptrdiff_t;
+
+private:
+    char const* pos_ = nullptr; // start of the current line
+    char const* eol_ = nullptr; // '\n' after the current line, or end_
+    char const* end_ = nullptr;
+
+    friend class line_range;
+
+    // Constructs an end iterator.
+    explicit line_iterator(char const* end) noexcept
+        : pos_(end)
+        , eol_(end)
+        , end_(end)
+    {
+    }
+
+    void find_eol() noexcept {
+        eol_ = pos_ + detail::find_byte(detail::as_byte_ptr(pos_), end_ - pos_, '\n');
+    }
+
+public:
+    line_iterator() noexcept = default;
+
+    // Returns an iterator to the first line of text.
+    explicit line_iterator(array_ref<char const> text) noexcept
+        : pos_(text.data())
+        , end_(text.data() + text.size())
+    {
+        find_eol();
+    }
+
+    reference operator*() const noexcept {
+        assert(pos_ != end_);
+        char const* last = eol_;
+        if (eol_ != end_ && last != pos_ && last[-1] == '\r')
+            --last;
+        return { pos_, last - pos_ };
+    }
+
+    line_iterator& operator++() noexcept {
+        assert(pos_ != end_);
+        pos_ = eol_ == end_ ? end_ : eol_ + 1;
+        find_eol();
+        return *this;
+    }
+
+    line_iterator operator++(int) noexcept {
+        auto t = *this;
+        ++*this;
+        return t;
+    }
+
+    // Returns the rest of the text, starting with the current line.
+    array_ref<char const> rest() const noexcept {
+        return { pos_, end_ - pos_ };
+    }
+
+    friend bool operator==(line_iterator const& lhs, line_iterator const& rhs) noexcept {
+        return lhs.pos_ == rhs.pos_;
+    }
+
+    friend bool operator!=(line_iterator const& lhs, line_iterator const& rhs) noexcept {
+        return !(lhs == rhs);
+    }
+};
+
+class line_range
+{
+    array_ref<char const> text_;
+
+public:
+    explicit line_range(array_ref<char const> text) noexcept
+        : text_(text)
+    {
+    }
+
+    line_iterator begin() const noexcept {
+        return line_iterator(text_);
+    }
+
+    line_iterator end() const noexcept {
+        return line_iterator(text_.data() + text_.size());
+    }
+};
+
+// Returns a range over the lines of text, for use in range-based for loops.
+inline line_range lines(array_ref<char const> text) noexcept
+{
+    return line_range(text);
+}
+
+// Stores the offsets of the first min(dst.size(), N) line starts of text to
+// dst and returns N, the number of lines. Call with an empty dst to count the
+// lines. text must be smaller than 4 GiB.
+//
+// The newlines are located 64 bytes at a time. Note that the offsets are
+// those of the line starts; a line ends before the next offset, minus the
+// '\n' and an optional '\r'.
+inline std::ptrdiff_t line_offsets(array_ref<char const> text, array_ref<uint32_t> dst) noexcept
+{
+    assert(text.size() <= std::ptrdiff_t{UINT32_MAX});
+
+    auto const p = detail::as_byte_ptr(text.data());
+    std::ptrdiff_t const n = text.size();
+    if (n == 0)
+        return 0;
+
+    std::ptrdiff_t count = 0;
+    auto const emit = [&](std::ptrdiff_t offset) {
+        if (count < dst.size())
+            dst[count] = static_cast<uint32_t>(offset);
+        ++count;
+    };
+
+    emit(0);
+
+    std::ptrdiff_t i = 0;
+#if defined(__AVX2__)
+    __m256i const nl = _mm256_set1_epi8('\n');
+    for ( ; i + 64 <= n; i += 64) {
+        uint32_t m[2] = {
+            static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(detail::load32(p + i), nl))),
+            static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(detail::load32(p + i + 32), nl))),
+        };
+        for (int h = 0; h < 2; ++h) {
+            for ( ; m[h] != 0; m[h] &= m[h] - 1) {
+                std::ptrdiff_t const next = i + 32 * h + detail::ctz32(m[h]) + 1;
+                if (next < n)
+                    emit(next);
+            }
+        }
+    }
+#endif
+
+    for ( ; i < n; ++i) {
+        if (p[i] == '\n' && i + 1 < n)
+            emit(i + 1);
+    }
+    return count;
+}
+
+} // namespace cxx
+
+//------------------------------------------------------------------------------
+// Copyright 2017 A. Bolz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
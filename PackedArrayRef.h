@@ -0,0 +1,552 @@
+// Distributed under the MIT license. See the end of the file for details.
+
+#pragma once
+
+#include "ArrayRef.h"
+
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <type_traits>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace cxx {
+
+namespace detail {
+
+template <unsigned Bits>
+constexpr uint64_t packed_mask = (uint64_t{1} << Bits) - 1;
+
+// Element i occupies the bits [i * Bits, (i + 1) * Bits) of the word array,
+// with bit 0 being the least significant bit of words[0].
+template <unsigned Bits>
+constexpr uint32_t packed_get(uint64_t const* words, std::ptrdiff_t index) noexcept
+{
+    uint64_t const bit = static_cast<uint64_t>(index) * Bits;
+    uint64_t const w = bit / 64;
+    unsigned const off = static_cast<unsigned>(bit % 64);
+
+    uint64_t v = words[w] >> off;
+    if (off + Bits > 64)
+        v |= words[w + 1] << (64 - off);
+
+    return static_cast<uint32_t>(v & packed_mask<Bits>);
+}
+
+template <unsigned Bits>
+constexpr void packed_set(uint64_t* words, std::ptrdiff_t index, uint32_t value) noexcept
+{
+    assert(value <= packed_mask<Bits>);
+
+    uint64_t const bit = static_cast<uint64_t>(index) * Bits;
+    uint64_t const w = bit / 64;
+    unsigned const off = static_cast<unsigned>(bit % 64);
+
+    words[w] = (words[w] & ~(packed_mask<Bits> << off)) | (uint64_t{value} << off);
+    if (off + Bits > 64) {
+        unsigned const hi = off + Bits - 64;
+        words[w + 1] = (words[w + 1] & ~((uint64_t{1} << hi) - 1)) | (uint64_t{value} >> (64 - off));
+    }
+}
+
+} // namespace detail
+
+//------------------------------------------------------------------------------
+//
+//------------------------------------------------------------------------------
+
+template <unsigned Bits>
+class packed_reference
+{
+    uint64_t* words_;
+    std::ptrdiff_t index_;
+
+public:
+    constexpr packed_reference(uint64_t* words, std::ptrdiff_t index) noexcept
+        : words_(words)
+        , index_(index)
+    {
+    }
+
+    constexpr packed_reference(packed_reference const&) noexcept = default;
+
+    constexpr operator uint32_t() const noexcept {
+        return detail::packed_get<Bits>(words_, index_);
+    }
+
+    constexpr packed_reference const& operator=(uint32_t value) const noexcept {
+        detail::packed_set<Bits>(words_, index_, value);
+        return *this;
+    }
+
+    constexpr packed_reference const& operator=(packed_reference const& rhs) const noexcept {
+        return *this = static_cast<uint32_t>(rhs);
+    }
+};
+
+//------------------------------------------------------------------------------
+//
+//------------------------------------------------------------------------------
+
+template <unsigned Bits, typename WordT = uint64_t>
+class packed_iterator
+{
+    static_assert(Bits >= 1 && Bits <= 32, "invalid template argument");
+    static_assert(std::is_same<std::remove_const_t<WordT>, uint64_t>::value, "invalid template argument");
+
+    template <unsigned, typename> friend class packed_iterator;
+
+public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type        = uint32_t;
+    using reference         = std::conditional_t<std::is_const<WordT>::value, uint32_t, packed_reference<Bits>>;
+    using pointer           = void;
+    using difference_type   = std::ptrdiff_t;
+
+private:
+    WordT* words_ = nullptr;
+    difference_type pos_ = 0;
+
+public:
+    constexpr packed_iterator() noexcept = default;
+
+    constexpr packed_iterator(WordT* words, difference_type pos) noexcept
+        : words_(words)
+        , pos_(pos)
+    {
+    }
+
+    template <typename OtherWordT, typename = std::enable_if_t< std::is_convertible<OtherWordT*, WordT*>::value >>
+    constexpr packed_iterator(packed_iterator<Bits, OtherWordT> const& it) noexcept
+        : words_(it.words_)
+        , pos_(it.pos_)
+    {
+    }
+
+private:
+    constexpr uint32_t deref(std::true_type) const noexcept {
+        return detail::packed_get<Bits>(words_, pos_);
+    }
+
+    constexpr packed_reference<Bits> deref(std::false_type) const noexcept {
+        return { words_, pos_ };
+    }
+
+public:
+    constexpr reference operator*() const noexcept {
+        return deref(std::is_const<WordT>{});
+    }
+
+    constexpr packed_iterator& operator++() noexcept {
+        ++pos_;
+        return *this;
+    }
+
+    constexpr packed_iterator operator++(int) noexcept {
+        auto t = *this;
+        ++(*this);
+        return t;
+    }
+
+    constexpr packed_iterator& operator--() noexcept {
+        --pos_;
+        return *this;
+    }
+
+    constexpr packed_iterator operator--(int) noexcept {
+        auto t = *this;
+        --(*this);
+        return t;
+    }
+
+    constexpr packed_iterator& operator+=(difference_type n) noexcept {
+        pos_ += n;
+        return *this;
+    }
+
+    constexpr packed_iterator operator+(difference_type n) const noexcept {
+        auto t = *this;
+        t += n;
+        return t;
+    }
+
+    constexpr friend packed_iterator operator+(difference_type n, packed_iterator it) noexcept {
+        return it + n;
+    }
+
+    constexpr packed_iterator& operator-=(difference_type n) noexcept {
+        pos_ -= n;
+        return *this;
+    }
+
+    constexpr packed_iterator operator-(difference_type n) const noexcept {
+        auto t = *this;
+        t -= n;
+        return t;
+    }
+
+    constexpr difference_type operator-(packed_iterator rhs) const noexcept {
+        assert(words_ == rhs.words_);
+        return pos_ - rhs.pos_;
+    }
+
+    constexpr reference operator[](difference_type index) const noexcept {
+        return *(*this + index);
+    }
+
+    constexpr friend bool operator==(packed_iterator lhs, packed_iterator rhs) noexcept {
+        assert(lhs.words_ == rhs.words_);
+        return lhs.pos_ == rhs.pos_;
+    }
+
+    constexpr friend bool operator!=(packed_iterator lhs, packed_iterator rhs) noexcept {
+        return !(lhs == rhs);
+    }
+
+    constexpr friend bool operator<(packed_iterator lhs, packed_iterator rhs) noexcept {
+        assert(lhs.words_ == rhs.words_);
+        return lhs.pos_ < rhs.pos_;
+    }
+
+    constexpr friend bool operator>(packed_iterator lhs, packed_iterator rhs) noexcept {
+        return rhs < lhs;
+    }
+
+    constexpr friend bool operator<=(packed_iterator lhs, packed_iterator rhs) noexcept {
+        return !(rhs < lhs);
+    }
+
+    constexpr friend bool operator>=(packed_iterator lhs, packed_iterator rhs) noexcept {
+        return !(lhs < rhs);
+    }
+};
+
+//------------------------------------------------------------------------------
+//
+//------------------------------------------------------------------------------
+
+// A view of an array of Bits-wide unsigned integers stored back to back in an
+// array of 64-bit words. Use packed_array_ref<Bits, uint64_t const> for a
+// read-only view.
+template <unsigned Bits, typename WordT = uint64_t>
+class packed_array_ref
+{
+public:
+    using iterator        = packed_iterator<Bits, WordT>;
+    using word_type       = WordT;
+    using value_type      = typename iterator::value_type;
+    using reference       = typename iterator::reference;
+    using difference_type = typename iterator::difference_type;
+
+    static constexpr unsigned bits = Bits;
+
+    // Returns the number of words required to store n elements.
+    static constexpr difference_type words_for(difference_type n) noexcept {
+        return static_cast<difference_type>((static_cast<uint64_t>(n) * Bits + 63) / 64);
+    }
+
+private:
+    word_type* words_ = nullptr;
+    difference_type first_ = 0;
+    difference_type size_ = 0;
+
+    static constexpr difference_type Min(difference_type x, difference_type y) {
+        return y < x ? y : x;
+    }
+
+    constexpr packed_array_ref(word_type* words, difference_type first, difference_type size) noexcept
+        : words_(words)
+        , first_(first)
+        , size_(size)
+    {
+    }
+
+public:
+    constexpr packed_array_ref() noexcept = default;
+    constexpr packed_array_ref(packed_array_ref const&) noexcept = default;
+    constexpr packed_array_ref& operator=(packed_array_ref const&) noexcept = default;
+
+    // The first n elements of words.
+    constexpr packed_array_ref(array_ref<word_type> words, difference_type n) noexcept
+        : words_(words.data())
+        , size_(n)
+    {
+        assert(n >= 0);
+        assert(words_for(n) <= words.size());
+    }
+
+    // As many elements as fit into words.
+    constexpr explicit packed_array_ref(array_ref<word_type> words) noexcept
+        : words_(words.data())
+        , size_(static_cast<difference_type>(static_cast<uint64_t>(words.size()) * 64 / Bits))
+    {
+    }
+
+    template <
+        typename OtherWordT,
+        typename = std::enable_if_t< std::is_convertible<OtherWordT*, word_type*>::value >
+    >
+    constexpr packed_array_ref(packed_array_ref<Bits, OtherWordT> const& rhs) noexcept
+        : words_(rhs.words())
+        , first_(rhs.first_index())
+        , size_(rhs.size())
+    {
+    }
+
+    // Returns the underlying word array. Element i of this view is element
+    // first_index() + i of the word array.
+    constexpr word_type* words() const noexcept {
+        return words_;
+    }
+
+    constexpr difference_type first_index() const noexcept {
+        return first_;
+    }
+
+    constexpr reference operator[](difference_type index) const noexcept {
+        assert(index >= 0);
+        assert(index < size_);
+        return begin()[index];
+    }
+
+    constexpr difference_type size() const noexcept {
+        return size_;
+    }
+
+    constexpr bool empty() const noexcept {
+        return size_ == 0;
+    }
+
+    constexpr iterator begin() const noexcept {
+        return iterator { words_, first_ };
+    }
+
+    constexpr iterator end() const noexcept {
+        return iterator { words_, first_ + size_ };
+    }
+
+    // Returns [begin(), begin() + n)
+    constexpr packed_array_ref take_front(difference_type n = 1) const noexcept {
+        n = Min(n, size());
+        return { words_, first_, n };
+    }
+
+    // Returns [end() - n, end())
+    constexpr packed_array_ref take_back(difference_type n = 1) const noexcept {
+        n = Min(n, size());
+        return { words_, first_ + size_ - n, n };
+    }
+
+    // Returns [begin() + n, end())
+    constexpr packed_array_ref drop_front(difference_type n = 1) const noexcept {
+        n = Min(n, size());
+        return { words_, first_ + n, size_ - n };
+    }
+
+    // Returns [begin(), end() - n)
+    constexpr packed_array_ref drop_back(difference_type n = 1) const noexcept {
+        n = Min(n, size());
+        return { words_, first_, size_ - n };
+    }
+
+    // Returns [first, first + n)
+    constexpr packed_array_ref slice(difference_type first, difference_type n) const noexcept {
+        return drop_front(first).take_front(n);
+    }
+
+    // Returns [first, end())
+    constexpr packed_array_ref slice(difference_type first) const noexcept {
+        return drop_front(first);
+    }
+};
+
+//------------------------------------------------------------------------------
+// Bulk conversion
+//------------------------------------------------------------------------------
+
+namespace detail {
+
+#if defined(__AVX2__)
+// Unpacks elements [first, first + n) 8 at a time. Each element is extracted
+// from an unaligned 64-bit load at its first byte, which covers all of its
+// bits since (bit % 8) + Bits <= 39. Returns the number of elements unpacked;
+// elements whose load would read past the last word are left to the caller.
+template <unsigned Bits>
+std::ptrdiff_t packed_unpack_avx2(uint64_t const* words, std::ptrdiff_t num_words, std::ptrdiff_t first, std::ptrdiff_t n, uint32_t* dst) noexcept
+{
+    auto const bytes = reinterpret_cast<long long const*>(words);
+    int64_t const num_bytes = static_cast<int64_t>(num_words) * 8;
+
+    // Bit offsets of the lanes relative to the first element of the block.
+    __m256i const lane_lo = _mm256_setr_epi64x(0 * Bits, 1 * Bits, 2 * Bits, 3 * Bits);
+    __m256i const lane_hi = _mm256_setr_epi64x(4 * Bits, 5 * Bits, 6 * Bits, 7 * Bits);
+    __m256i const seven = _mm256_set1_epi64x(7);
+    __m256i const mask = _mm256_set1_epi64x(static_cast<long long>(packed_mask<Bits>));
+    __m256i const even = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+
+    std::ptrdiff_t i = 0;
+    for ( ; i + 8 <= n; i += 8) {
+        int64_t const bit = static_cast<int64_t>(first + i) * Bits;
+        if ((bit + 7 * Bits) / 8 + 8 > num_bytes)
+            break;
+
+        __m256i const base = _mm256_set1_epi64x(bit);
+        __m256i const b_lo = _mm256_add_epi64(base, lane_lo);
+        __m256i const b_hi = _mm256_add_epi64(base, lane_hi);
+
+        __m256i v_lo = _mm256_i64gather_epi64(bytes, _mm256_srli_epi64(b_lo, 3), 1);
+        __m256i v_hi = _mm256_i64gather_epi64(bytes, _mm256_srli_epi64(b_hi, 3), 1);
+        v_lo = _mm256_and_si256(_mm256_srlv_epi64(v_lo, _mm256_and_si256(b_lo, seven)), mask);
+        v_hi = _mm256_and_si256(_mm256_srlv_epi64(v_hi, _mm256_and_si256(b_hi, seven)), mask);
+
+        // Narrow the 64-bit lanes to 32 bits.
+        __m256i const lo = _mm256_permutevar8x32_epi32(v_lo, even);
+        __m256i const hi = _mm256_permutevar8x32_epi32(v_hi, even);
+        __m256i const r = _mm256_blend_epi32(lo, hi, 0xF0);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), r);
+    }
+    return i;
+}
+
+// Packs src[0, n) into whole words at out, for Bits dividing 64, 256 bits (4
+// words) at a time: adjacent 32-bit slots are merged into one of twice the
+// width by shift-and-OR, and the slots are then narrowed back to 32 bits,
+// until each 64-bit lane holds a full word. Returns the number of elements
+// packed; the remainder is left to the caller.
+template <unsigned Bits>
+std::ptrdiff_t packed_pack_avx2(uint32_t const* src, std::ptrdiff_t n, uint64_t* out) noexcept
+{
+    static_assert(64 % Bits == 0, "invalid template argument");
+    constexpr int num_vectors = 32 / Bits;
+    constexpr std::ptrdiff_t block = 8 * num_vectors;
+
+    __m256i const lo32 = _mm256_set1_epi64x(0xFFFFFFFF);
+    __m256i const even = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+
+    std::ptrdiff_t i = 0;
+    for ( ; i + block <= n; i += block) {
+        __m256i v[num_vectors];
+        for (int j = 0; j < num_vectors; ++j)
+            v[j] = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(src + i + 8 * j));
+
+        int count = num_vectors;
+        for (unsigned w = Bits; w < 32; w *= 2, count /= 2) {
+            // Slots hold values of w <= 16 bits, so x >> (32 - w) moves the
+            // upper slot of each lane next to the lower one and shifts the
+            // lower one out.
+            __m128i const shift = _mm_cvtsi32_si128(static_cast<int>(32 - w));
+            for (int j = 0; j < count / 2; ++j) {
+                __m256i const a = _mm256_or_si256(_mm256_and_si256(v[2 * j], lo32), _mm256_srl_epi64(v[2 * j], shift));
+                __m256i const b = _mm256_or_si256(_mm256_and_si256(v[2 * j + 1], lo32), _mm256_srl_epi64(v[2 * j + 1], shift));
+                v[j] = _mm256_blend_epi32(_mm256_permutevar8x32_epi32(a, even), _mm256_permutevar8x32_epi32(b, even), 0xF0);
+            }
+        }
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), v[0]);
+        out += 4;
+    }
+    return i;
+}
+#endif
+
+} // namespace detail
+
+// Copies the elements of src into the front of dst.
+template <unsigned Bits, typename WordT>
+void unpack(packed_array_ref<Bits, WordT> src, array_ref<uint32_t> dst) noexcept
+{
+    assert(dst.size() >= src.size());
+
+    uint64_t const* const words = src.words();
+    std::ptrdiff_t const first = src.first_index();
+    std::ptrdiff_t const n = src.size();
+
+    std::ptrdiff_t i = 0;
+#if defined(__AVX2__)
+    std::ptrdiff_t const num_words = src.words_for(first + n);
+    i = detail::packed_unpack_avx2<Bits>(words, num_words, first, n, dst.data());
+#endif
+    for ( ; i < n; ++i)
+        dst[i] = detail::packed_get<Bits>(words, first + i);
+}
+
+// Copies the elements of src into dst. All values must fit into Bits bits.
+// Whole words are written at once; only the partial words at the ends of dst
+// are read.
+template <unsigned Bits>
+void pack(array_ref<uint32_t const> src, packed_array_ref<Bits> dst) noexcept
+{
+    assert(dst.size() >= src.size());
+#ifndef NDEBUG
+    for (auto v : src)
+        assert(v <= detail::packed_mask<Bits>);
+#endif
+
+    std::ptrdiff_t const n = src.size();
+    if (n == 0)
+        return;
+
+    uint64_t* words = dst.words();
+    uint64_t const first_bit = static_cast<uint64_t>(dst.first_index()) * Bits;
+
+    uint64_t* out = words + first_bit / 64;
+    unsigned used = static_cast<unsigned>(first_bit % 64);
+    uint64_t acc = *out & ((uint64_t{1} << used) - 1);
+
+    auto const push = [&](uint64_t v) {
+        acc |= v << used;
+        used += Bits;
+        if (used >= 64) {
+            *out++ = acc;
+            used -= 64;
+            acc = v >> (Bits - used);
+        }
+    };
+
+    std::ptrdiff_t i = 0;
+#if defined(__AVX2__)
+    if constexpr (64 % Bits == 0) {
+        // Up to the next word boundary, then whole blocks of words.
+        for ( ; i < n && used != 0; ++i)
+            push(src[i]);
+        if (used == 0) {
+            std::ptrdiff_t const m = detail::packed_pack_avx2<Bits>(src.data() + i, n - i, out);
+            i += m;
+            out += m / (64 / Bits);
+        }
+    }
+#endif
+    for ( ; i < n; ++i)
+        push(src[i]);
+
+    if (used > 0) {
+        uint64_t const keep = ~((uint64_t{1} << used) - 1);
+        *out = (*out & keep) | acc;
+    }
+}
+
+} // namespace cxx
+
+//------------------------------------------------------------------------------
+// Copyright 2017 A. Bolz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
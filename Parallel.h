@@ -0,0 +1,181 @@
+// Distributed under the MIT license. See the end of the file for details.
+
+#pragma once
+
+#include "ArrayRef.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace cxx {
+
+namespace detail {
+
+// Returns the CPUs the calling thread may run on, in ascending order, which
+// usually keeps the CPUs of a NUMA node together. Honors taskset and cgroup
+// restrictions.
+inline std::vector<int> allowed_cpus()
+{
+    std::vector<int> cpus;
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int c = 0; c < CPU_SETSIZE; ++c) {
+            if (CPU_ISSET(c, &set))
+                cpus.push_back(c);
+        }
+    }
+#endif
+    return cpus;
+}
+
+// Pins the calling thread to the given CPU.
+inline void pin_to_cpu(int cpu) noexcept
+{
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+    static_cast<void>(cpu);
+#endif
+}
+
+} // namespace detail
+
+// Splits an array into one contiguous part per thread, with the part
+// boundaries aligned to grain_bytes (a page by default) so that no page is
+// shared between two threads. Thread t always gets the same part of the
+// same array, and with pinning always runs on the same CPU. Using the same
+// partitioner for the first touch of an array and for the work on it thus
+// places each page on the NUMA node of the thread which processes it.
+class static_partitioner
+{
+    int threads_;
+    std::ptrdiff_t grain_bytes_;
+    bool pin_;
+
+public:
+    // threads = 0 uses one thread per CPU the process may run on.
+    explicit static_partitioner(int threads = 0, bool pin = true, std::ptrdiff_t grain_bytes = 4096)
+        : threads_(threads > 0 ? threads : static_cast<int>(detail::allowed_cpus().size()))
+        , grain_bytes_(grain_bytes)
+        , pin_(pin)
+    {
+        if (threads_ <= 0)
+            threads_ = static_cast<int>(std::thread::hardware_concurrency());
+        if (threads_ <= 0)
+            threads_ = 1;
+        assert(grain_bytes_ > 0);
+    }
+
+    int threads() const noexcept {
+        return threads_;
+    }
+
+    bool pin() const noexcept {
+        return pin_;
+    }
+
+    // Returns the part of arr processed by thread t.
+    template <typename T>
+    array_ref<T> part(array_ref<T> arr, int t) const noexcept
+    {
+        assert(t >= 0 && t < threads_);
+        return arr.subarray(boundary(arr, t), boundary(arr, t + 1));
+    }
+
+private:
+    template <typename T>
+    std::ptrdiff_t boundary(array_ref<T> arr, int k) const noexcept
+    {
+        std::ptrdiff_t const n = arr.size();
+        if (k == 0)
+            return 0;
+        if (k >= threads_)
+            return n;
+
+        // Round the even split up to the next grain boundary in memory.
+        std::ptrdiff_t const even = (n + threads_ - 1) / threads_ * k;
+        auto const base = reinterpret_cast<std::uintptr_t>(arr.data());
+        auto const grain = static_cast<std::uintptr_t>(grain_bytes_);
+        std::uintptr_t const addr = base + static_cast<std::uintptr_t>(even) * sizeof(T);
+        std::uintptr_t const aligned = (addr + grain - 1) / grain * grain;
+        auto const i = static_cast<std::ptrdiff_t>((aligned - base + sizeof(T) - 1) / sizeof(T));
+        return i < n ? i : n;
+    }
+};
+
+// Calls f(part, t) for each thread t of the partitioner, each on its own
+// thread, and waits for all of them. With pinning, thread t runs on the t-th
+// CPU (modulo their number) of the calling thread's affinity mask. With a
+// single thread, f is called on the calling thread.
+template <typename T, typename F>
+void parallel_for(array_ref<T> arr, static_partitioner const& partitioner, F f)
+{
+    if (partitioner.threads() == 1) {
+        f(arr, 0);
+        return;
+    }
+
+    std::vector<int> const cpus = partitioner.pin() ? detail::allowed_cpus() : std::vector<int>();
+
+    // The calling thread does not take a part itself: pinning would change
+    // its affinity for good.
+    std::vector<std::thread> threads;
+    threads.reserve(static_cast<std::size_t>(partitioner.threads()));
+    for (int t = 0; t < partitioner.threads(); ++t) {
+        threads.emplace_back([&, t] {
+            if (!cpus.empty())
+                detail::pin_to_cpu(cpus[static_cast<std::size_t>(t) % cpus.size()]);
+            f(partitioner.part(arr, t), t);
+        });
+    }
+    for (auto& th : threads)
+        th.join();
+}
+
+// Initializes the elements of arr to value, each part from the thread which
+// will process it when parallel_for is later called with the same
+// partitioner. Use this on freshly allocated memory (e.g. a huge_array or a
+// large std::malloc), before any other access: the kernel places each page
+// on the NUMA node of the thread which touches it first.
+template <typename T>
+void parallel_first_touch(array_ref<T> arr, static_partitioner const& partitioner, typename array_ref<T>::value_type const& value = {})
+{
+    parallel_for(arr, partitioner, [&](array_ref<T> part, int) {
+        std::fill(part.data(), part.data() + part.size(), value);
+    });
+}
+
+} // namespace cxx
+
+//------------------------------------------------------------------------------
+// Copyright 2017 A. Bolz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
@@ -0,0 +1,256 @@
+// Distributed under the MIT license. See the end of the file for details.
+
+#pragma once
+
+#include "ArrayRef.h"
+#include "Algorithm.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+
+namespace cxx {
+
+namespace detail {
+
+constexpr uint64_t ph_mix(uint64_t x) noexcept
+{
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdull;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ull;
+    x ^= x >> 33;
+    return x;
+}
+
+} // namespace detail
+
+// Seeded hash functions usable in constant expressions. Specialize for other
+// key types.
+template <typename Key, typename = void>
+struct perfect_hash;
+
+template <typename Key>
+struct perfect_hash<Key, std::enable_if_t< std::is_integral<Key>::value || std::is_enum<Key>::value >>
+{
+    constexpr uint64_t operator()(Key key, uint64_t seed) const noexcept {
+        return detail::ph_mix(static_cast<uint64_t>(key) ^ seed);
+    }
+};
+
+template <>
+struct perfect_hash<std::string_view>
+{
+    // FNV-1a, followed by a finalizer.
+    constexpr uint64_t operator()(std::string_view key, uint64_t seed) const noexcept {
+        uint64_t h = 0xcbf29ce484222325ull ^ seed;
+        for (char c : key) {
+            h ^= static_cast<unsigned char>(c);
+            h *= 0x100000001b3ull;
+        }
+        return detail::ph_mix(h);
+    }
+};
+
+//------------------------------------------------------------------------------
+//
+//------------------------------------------------------------------------------
+
+// A read-only map from N distinct keys to values, built with a minimal
+// perfect hash function. Intended to be constructed in a constant
+// expression, so that lookups in static keyword or opcode tables do not need
+// any initialization at startup:
+//
+//  static constexpr std::string_view names[] = { "add", "sub", "mul" };
+//  static constexpr int opcodes[] = { 1, 2, 3 };
+//  constexpr auto ops = cxx::make_perfect_hash_map(names, opcodes);
+//  ops.find("sub") // -> pointer to 2
+//
+// The construction follows PTHash: the keys are distributed into about N/4
+// buckets, and the buckets are processed from the largest to the smallest.
+// For each one a pilot value is searched, such that the keys of the bucket
+// are mapped to different free slots by
+//
+//  slot = (hash(key) ^ mix(pilot)) % N
+//
+// A lookup computes one hash, reads one pilot and compares one key.
+template <typename Key, typename Value, std::size_t N, typename Hash = perfect_hash<Key>>
+class perfect_hash_map
+{
+    static constexpr std::size_t num_buckets = N / 4 + 1;
+
+    std::array<Key, N> keys_ {};
+    std::array<Value, N> values_ {};
+    std::array<uint32_t, num_buckets> pilots_ {};
+    uint64_t seed_ = 0;
+
+    constexpr uint64_t hash(Key const& key) const noexcept {
+        return Hash{}(key, seed_);
+    }
+
+    static constexpr std::size_t bucket(uint64_t h) noexcept {
+        return static_cast<std::size_t>((h >> 32) % num_buckets);
+    }
+
+    static constexpr std::size_t slot(uint64_t h, uint32_t pilot) noexcept {
+        return static_cast<std::size_t>((h ^ detail::ph_mix(pilot)) % N);
+    }
+
+    // Tries to find pilots for the current seed.
+    constexpr bool build(array_ref<Key const> keys)
+    {
+        std::array<uint64_t, N> hashes {};
+        std::array<uint32_t, num_buckets + 1> starts {};
+        for (std::size_t i = 0; i < N; ++i) {
+            hashes[i] = hash(keys[i]);
+            ++starts[bucket(hashes[i]) + 1];
+        }
+        for (std::size_t b = 0; b < num_buckets; ++b)
+            starts[b + 1] += starts[b];
+
+        // The keys, grouped by bucket.
+        std::array<uint32_t, N> members {};
+        std::array<uint32_t, num_buckets + 1> fill = starts;
+        for (std::size_t i = 0; i < N; ++i)
+            members[fill[bucket(hashes[i])]++] = static_cast<uint32_t>(i);
+
+        std::array<uint32_t, num_buckets> order {};
+        for (std::size_t b = 0; b < num_buckets; ++b)
+            order[b] = static_cast<uint32_t>(b);
+        cxx::sort(array_ref<uint32_t>(order), [&](uint32_t x, uint32_t y) {
+            return starts[x + 1] - starts[x] > starts[y + 1] - starts[y];
+        });
+
+        std::array<bool, N> taken {};
+        uint32_t const max_pilot = static_cast<uint32_t>(16 * N + 256);
+
+        for (uint32_t const b : order) {
+            uint32_t const first = starts[b];
+            uint32_t const last = starts[b + 1];
+            if (first == last)
+                break;
+
+            // Keys with equal hashes can not be separated by any pilot.
+            for (uint32_t i = first; i < last; ++i) {
+                for (uint32_t j = first; j < i; ++j) {
+                    if (hashes[members[i]] == hashes[members[j]]) {
+                        if (keys[members[i]] == keys[members[j]])
+                            throw std::invalid_argument("perfect_hash_map: duplicate key");
+                        return false;
+                    }
+                }
+            }
+
+            uint32_t pilot = 0;
+            for ( ; pilot < max_pilot; ++pilot) {
+                uint32_t i = first;
+                for ( ; i < last; ++i) {
+                    std::size_t const s = slot(hashes[members[i]], pilot);
+                    if (taken[s])
+                        break;
+                    taken[s] = true;
+                }
+                if (i == last)
+                    break;
+                // Undo
+                for (uint32_t j = first; j < i; ++j)
+                    taken[slot(hashes[members[j]], pilot)] = false;
+            }
+            if (pilot == max_pilot)
+                return false;
+
+            pilots_[b] = pilot;
+        }
+        return true;
+    }
+
+public:
+    // Builds the map from keys[i] -> values[i]. Both arrays must have N
+    // elements. Throws std::invalid_argument if the keys are not distinct (or
+    // if no hash function can be found), which makes this a compile error in
+    // a constant expression.
+    constexpr perfect_hash_map(array_ref<Key const> keys, array_ref<Value const> values)
+    {
+        assert(keys.size() == static_cast<std::ptrdiff_t>(N));
+        assert(values.size() == static_cast<std::ptrdiff_t>(N));
+
+        if (N == 0)
+            return;
+
+        bool ok = false;
+        for (uint64_t attempt = 1; !ok && attempt <= 64; ++attempt) {
+            seed_ = detail::ph_mix(attempt);
+            pilots_ = {};
+            ok = build(keys);
+        }
+        if (!ok)
+            throw std::invalid_argument("perfect_hash_map: no perfect hash function found");
+
+        for (std::size_t i = 0; i < N; ++i) {
+            uint64_t const h = hash(keys[i]);
+            std::size_t const s = slot(h, pilots_[bucket(h)]);
+            keys_[s] = keys[i];
+            values_[s] = values[i];
+        }
+    }
+
+    static constexpr std::size_t size() noexcept {
+        return N;
+    }
+
+    // Returns the value for key, or nullptr if key is not in the map.
+    constexpr Value const* find(Key const& key) const noexcept
+    {
+        if (N == 0)
+            return nullptr;
+
+        uint64_t const h = hash(key);
+        std::size_t const s = slot(h, pilots_[bucket(h)]);
+        return keys_[s] == key ? &values_[s] : nullptr;
+    }
+
+    constexpr bool contains(Key const& key) const noexcept {
+        return find(key) != nullptr;
+    }
+
+    // Returns the keys resp. values in slot order.
+    constexpr array_ref<Key const> keys() const noexcept {
+        return keys_;
+    }
+
+    constexpr array_ref<Value const> values() const noexcept {
+        return values_;
+    }
+};
+
+template <typename Key, typename Value, std::size_t N>
+constexpr perfect_hash_map<Key, Value, N> make_perfect_hash_map(Key const (&keys)[N], Value const (&values)[N])
+{
+    return { keys, values };
+}
+
+} // namespace cxx
+
+//------------------------------------------------------------------------------
+// Copyright 2017 A. Bolz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
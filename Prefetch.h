@@ -0,0 +1,319 @@
+// Distributed under the MIT license. See the end of the file for details.
+
+#pragma once
+
+#include "ArrayRef.h"
+
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <xmmintrin.h>
+#endif
+
+namespace cxx {
+
+inline void prefetch_read(void const* p) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(p, 0, 3);
+#elif defined(_MSC_VER)
+    _mm_prefetch(static_cast<char const*>(p), _MM_HINT_T0);
+#else
+    static_cast<void>(p);
+#endif
+}
+
+inline void prefetch_write(void const* p) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(p, 1, 3);
+#elif defined(_MSC_VER)
+    _mm_prefetch(static_cast<char const*>(p), _MM_HINT_T0);
+#else
+    static_cast<void>(p);
+#endif
+}
+
+//------------------------------------------------------------------------------
+// Address functions for prefetch_iterator
+//------------------------------------------------------------------------------
+
+// Prefetches the element itself.
+struct prefetch_element
+{
+    template <typename T>
+    constexpr void const* operator()(T& x) const noexcept {
+        return &x;
+    }
+};
+
+// Prefetches the object the element points to.
+struct prefetch_pointee
+{
+    template <typename T>
+    constexpr void const* operator()(T* x) const noexcept {
+        return x;
+    }
+};
+
+// Prefetches base[x], for iterating over an array of indices.
+template <typename T>
+struct prefetch_indexed
+{
+    T* base = nullptr;
+
+    template <typename I>
+    constexpr void const* operator()(I x) const noexcept {
+        return base + x;
+    }
+};
+
+//------------------------------------------------------------------------------
+//
+//------------------------------------------------------------------------------
+
+// Wraps an array_iterator and prefetches addr(it[distance]) whenever the
+// iterator is advanced. A distance of 0 disables prefetching.
+template <typename PointerT, typename AddressFn = prefetch_element>
+class prefetch_iterator
+{
+public:
+    using base_iterator     = array_iterator<PointerT>;
+    using iterator_category = std::random_access_iterator_tag;
+    using element_type      = typename base_iterator::element_type;
+    using value_type        = typename base_iterator::value_type;
+    using reference         = typename base_iterator::reference;
+    using pointer           = typename base_iterator::pointer;
+    using difference_type   = typename base_iterator::difference_type;
+
+private:
+    base_iterator it_;
+    pointer last_ = nullptr;
+    difference_type distance_ = 0;
+    AddressFn addr_;
+
+    void prefetch() const noexcept {
+        if (distance_ > 0 && distance_ < last_ - it_.ptr())
+            prefetch_read(addr_(it_.ptr()[distance_]));
+    }
+
+public:
+    constexpr prefetch_iterator() noexcept = default;
+
+    constexpr prefetch_iterator(base_iterator it, pointer last, difference_type distance, AddressFn addr = {}) noexcept
+        : it_(it)
+        , last_(last)
+        , distance_(distance)
+        , addr_(addr)
+    {
+        assert(distance_ >= 0);
+    }
+
+    constexpr base_iterator base() const noexcept {
+        return it_;
+    }
+
+    constexpr difference_type distance() const noexcept {
+        return distance_;
+    }
+
+    constexpr reference operator*() const noexcept {
+        return *it_;
+    }
+
+    constexpr pointer operator->() const noexcept {
+        return it_.operator->();
+    }
+
+    prefetch_iterator& operator++() noexcept {
+        ++it_;
+        prefetch();
+        return *this;
+    }
+
+    prefetch_iterator operator++(int) noexcept {
+        auto t = *this;
+        ++(*this);
+        return t;
+    }
+
+    constexpr prefetch_iterator& operator--() noexcept {
+        --it_;
+        return *this;
+    }
+
+    constexpr prefetch_iterator operator--(int) noexcept {
+        auto t = *this;
+        --(*this);
+        return t;
+    }
+
+    prefetch_iterator& operator+=(difference_type n) noexcept {
+        it_ += n;
+        prefetch();
+        return *this;
+    }
+
+    prefetch_iterator operator+(difference_type n) const noexcept {
+        auto t = *this;
+        t += n;
+        return t;
+    }
+
+    friend prefetch_iterator operator+(difference_type n, prefetch_iterator it) noexcept {
+        return it + n;
+    }
+
+    constexpr prefetch_iterator& operator-=(difference_type n) noexcept {
+        it_ -= n;
+        return *this;
+    }
+
+    constexpr prefetch_iterator operator-(difference_type n) const noexcept {
+        auto t = *this;
+        t -= n;
+        return t;
+    }
+
+    constexpr difference_type operator-(prefetch_iterator rhs) const noexcept {
+        return it_ - rhs.it_;
+    }
+
+    constexpr reference operator[](difference_type index) const noexcept {
+        return it_[index];
+    }
+
+    constexpr friend bool operator==(prefetch_iterator lhs, prefetch_iterator rhs) noexcept {
+        return lhs.it_ == rhs.it_;
+    }
+
+    constexpr friend bool operator!=(prefetch_iterator lhs, prefetch_iterator rhs) noexcept {
+        return !(lhs == rhs);
+    }
+
+    constexpr friend bool operator<(prefetch_iterator lhs, prefetch_iterator rhs) noexcept {
+        return lhs.it_ < rhs.it_;
+    }
+
+    constexpr friend bool operator>(prefetch_iterator lhs, prefetch_iterator rhs) noexcept {
+        return rhs < lhs;
+    }
+
+    constexpr friend bool operator<=(prefetch_iterator lhs, prefetch_iterator rhs) noexcept {
+        return !(rhs < lhs);
+    }
+
+    constexpr friend bool operator>=(prefetch_iterator lhs, prefetch_iterator rhs) noexcept {
+        return !(lhs < rhs);
+    }
+};
+
+//------------------------------------------------------------------------------
+//
+//------------------------------------------------------------------------------
+
+template <typename T, typename AddressFn = prefetch_element>
+class prefetch_range
+{
+public:
+    using iterator        = prefetch_iterator<T*, AddressFn>;
+    using element_type    = typename iterator::element_type;
+    using difference_type = typename iterator::difference_type;
+
+private:
+    array_ref<T> arr_;
+    difference_type distance_ = 0;
+    AddressFn addr_;
+
+public:
+    constexpr prefetch_range() noexcept = default;
+
+    constexpr prefetch_range(array_ref<T> arr, difference_type distance, AddressFn addr = {}) noexcept
+        : arr_(arr)
+        , distance_(distance)
+        , addr_(addr)
+    {
+        assert(distance_ >= 0);
+    }
+
+    constexpr array_ref<T> base() const noexcept {
+        return arr_;
+    }
+
+    constexpr difference_type distance() const noexcept {
+        return distance_;
+    }
+
+    constexpr void set_distance(difference_type distance) noexcept {
+        assert(distance >= 0);
+        distance_ = distance;
+    }
+
+    constexpr difference_type size() const noexcept {
+        return arr_.size();
+    }
+
+    constexpr bool empty() const noexcept {
+        return arr_.empty();
+    }
+
+    // Issues the prefetches for arr[0] to arr[distance()]; advancing the
+    // iterator prefetches the rest.
+    iterator begin() const noexcept {
+        auto const n = distance_ == 0 ? 0 : (distance_ < arr_.size() ? distance_ + 1 : arr_.size());
+        for (difference_type i = 0; i < n; ++i)
+            prefetch_read(addr_(arr_[i]));
+
+        return iterator { arr_.begin(), arr_.data() + arr_.size(), distance_, addr_ };
+    }
+
+    constexpr iterator end() const noexcept {
+        return iterator { arr_.end(), arr_.data() + arr_.size(), distance_, addr_ };
+    }
+};
+
+// Iterates over arr and prefetches arr[i + distance].
+template <typename T>
+constexpr prefetch_range<T> prefetch_elements(array_ref<T> arr, std::ptrdiff_t distance) noexcept
+{
+    return { arr, distance };
+}
+
+// Iterates over arr and prefetches *arr[i + distance].
+template <typename T>
+constexpr prefetch_range<T, prefetch_pointee> prefetch_pointees(array_ref<T> arr, std::ptrdiff_t distance) noexcept
+{
+    static_assert(std::is_pointer<std::remove_cv_t<T>>::value, "invalid template argument");
+    return { arr, distance };
+}
+
+// Iterates over idx and prefetches data[idx[i + distance]].
+template <typename I, typename T>
+constexpr prefetch_range<I, prefetch_indexed<T>> prefetch_indexed_elements(array_ref<I> idx, array_ref<T> data, std::ptrdiff_t distance) noexcept
+{
+    static_assert(std::is_integral<std::remove_cv_t<I>>::value, "invalid template argument");
+    return { idx, distance, prefetch_indexed<T>{data.data()} };
+}
+
+} // namespace cxx
+
+//------------------------------------------------------------------------------
+// Copyright 2017 A. Bolz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
@@ -0,0 +1,420 @@
+// Distributed under the MIT license. See the end of the file for details.
+
+#pragma once
+
+#include "ArrayRef.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_IX86)
+#include <emmintrin.h>
+#endif
+
+namespace cxx {
+
+namespace detail {
+
+constexpr std::size_t queue_cache_line_size = 64;
+
+inline void cpu_relax() noexcept {
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_IX86)
+    _mm_pause();
+#else
+    std::this_thread::yield();
+#endif
+}
+
+} // namespace detail
+
+//------------------------------------------------------------------------------
+// Bounded single-producer/single-consumer queue
+//------------------------------------------------------------------------------
+
+// The slots are caller-provided and must outlive the queue. Elements are
+// assigned into and out of the slots, never constructed or destroyed.
+//
+// begin_push/begin_pop return a contiguous window of free resp. filled slots
+// which may be smaller than requested (or empty) at the wrap-around point.
+// The window must be handed back to end_push/end_pop before the next call to
+// begin_push/begin_pop.
+template <typename T>
+class spsc_queue
+{
+    static_assert(!std::is_const<T>::value, "invalid template argument");
+
+public:
+    using element_type    = T;
+    using difference_type = std::ptrdiff_t;
+
+private:
+    array_ref<T> slots_;
+
+    // Consumer side
+    alignas(detail::queue_cache_line_size) std::atomic<uint64_t> head_ { 0 };
+    uint64_t cached_tail_ = 0;
+
+    // Producer side
+    alignas(detail::queue_cache_line_size) std::atomic<uint64_t> tail_ { 0 };
+    uint64_t cached_head_ = 0;
+
+    uint64_t capacity_u() const noexcept {
+        return static_cast<uint64_t>(slots_.size());
+    }
+
+public:
+    explicit spsc_queue(array_ref<T> slots) noexcept
+        : slots_(slots)
+    {
+        assert(slots_.size() > 0);
+    }
+
+    spsc_queue(spsc_queue const&) = delete;
+    spsc_queue& operator=(spsc_queue const&) = delete;
+
+    difference_type capacity() const noexcept {
+        return slots_.size();
+    }
+
+    // Returns the number of elements in the queue. Only approximate if called
+    // concurrently with push or pop operations.
+    difference_type size() const noexcept {
+        uint64_t const h = head_.load(std::memory_order_acquire);
+        uint64_t const t = tail_.load(std::memory_order_acquire);
+        return static_cast<difference_type>(t - h);
+    }
+
+    bool empty() const noexcept {
+        return size() == 0;
+    }
+
+    // Producer: returns up to n free slots.
+    array_ref<T> begin_push(difference_type n) noexcept
+    {
+        assert(n >= 0);
+
+        // Only touch the consumer's cache line if the cached head does not
+        // leave enough room for the request.
+        uint64_t const t = tail_.load(std::memory_order_relaxed);
+        uint64_t free = capacity_u() - (t - cached_head_);
+        if (free < static_cast<uint64_t>(n)) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            free = capacity_u() - (t - cached_head_);
+        }
+
+        uint64_t const pos = t % capacity_u();
+        uint64_t k = capacity_u() - pos;
+        if (k > free)
+            k = free;
+        if (k > static_cast<uint64_t>(n))
+            k = static_cast<uint64_t>(n);
+
+        return slots_.slice(static_cast<difference_type>(pos), static_cast<difference_type>(k));
+    }
+
+    // Producer: publishes the first n slots of the last window returned by
+    // begin_push.
+    void end_push(difference_type n) noexcept
+    {
+        assert(n >= 0);
+        uint64_t const t = tail_.load(std::memory_order_relaxed);
+        assert(t + static_cast<uint64_t>(n) - cached_head_ <= capacity_u());
+        tail_.store(t + static_cast<uint64_t>(n), std::memory_order_release);
+    }
+
+    void end_push(array_ref<T> window) noexcept
+    {
+        end_push(window.size());
+    }
+
+    // Consumer: returns up to n filled slots.
+    array_ref<T> begin_pop(difference_type n) noexcept
+    {
+        assert(n >= 0);
+
+        uint64_t const h = head_.load(std::memory_order_relaxed);
+        uint64_t used = cached_tail_ - h;
+        if (used < static_cast<uint64_t>(n)) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            used = cached_tail_ - h;
+        }
+
+        uint64_t const pos = h % capacity_u();
+        uint64_t k = capacity_u() - pos;
+        if (k > used)
+            k = used;
+        if (k > static_cast<uint64_t>(n))
+            k = static_cast<uint64_t>(n);
+
+        return slots_.slice(static_cast<difference_type>(pos), static_cast<difference_type>(k));
+    }
+
+    // Consumer: releases the first n slots of the last window returned by
+    // begin_pop.
+    void end_pop(difference_type n) noexcept
+    {
+        assert(n >= 0);
+        uint64_t const h = head_.load(std::memory_order_relaxed);
+        assert(h + static_cast<uint64_t>(n) <= cached_tail_);
+        head_.store(h + static_cast<uint64_t>(n), std::memory_order_release);
+    }
+
+    void end_pop(array_ref<T> window) noexcept
+    {
+        end_pop(window.size());
+    }
+
+    bool try_push(T const& value) noexcept(std::is_nothrow_copy_assignable<T>::value)
+    {
+        auto const w = begin_push(1);
+        if (w.empty())
+            return false;
+        w[0] = value;
+        end_push(w);
+        return true;
+    }
+
+    bool try_pop(T& value) noexcept(std::is_nothrow_move_assignable<T>::value)
+    {
+        auto const w = begin_pop(1);
+        if (w.empty())
+            return false;
+        value = std::move(w[0]);
+        end_pop(w);
+        return true;
+    }
+
+    // Pushes as many elements from the front of items as fit and returns
+    // their number.
+    difference_type push(array_ref<T const> items) noexcept(std::is_nothrow_copy_assignable<T>::value)
+    {
+        difference_type count = 0;
+        for (;;) {
+            auto const w = begin_push(items.size() - count);
+            if (w.empty())
+                return count;
+            std::copy(items.begin() + count, items.begin() + count + w.size(), w.begin());
+            end_push(w);
+            count += w.size();
+        }
+    }
+
+    // Pops up to out.size() elements into the front of out and returns their
+    // number.
+    difference_type pop(array_ref<T> out) noexcept(std::is_nothrow_move_assignable<T>::value)
+    {
+        difference_type count = 0;
+        for (;;) {
+            auto const w = begin_pop(out.size() - count);
+            if (w.empty())
+                return count;
+            std::move(w.begin(), w.end(), out.begin() + count);
+            end_pop(w);
+            count += w.size();
+        }
+    }
+};
+
+//------------------------------------------------------------------------------
+// Bounded multi-producer/multi-consumer queue
+//------------------------------------------------------------------------------
+
+// Each side keeps a head (reserved) and a tail (published) index. A thread
+// reserves a window by advancing the head with a CAS and publishes it by
+// advancing the tail once all earlier windows of the same side have been
+// published, so windows become visible in reservation order.
+//
+// Every window returned by begin_push/begin_pop must be handed back to
+// end_push/end_pop in full; other threads wait for it.
+template <typename T>
+class mpmc_queue
+{
+    static_assert(!std::is_const<T>::value, "invalid template argument");
+
+public:
+    using element_type    = T;
+    using difference_type = std::ptrdiff_t;
+
+private:
+    array_ref<T> slots_;
+
+    alignas(detail::queue_cache_line_size) std::atomic<uint64_t> prod_head_ { 0 };
+    std::atomic<uint64_t> prod_tail_ { 0 };
+
+    alignas(detail::queue_cache_line_size) std::atomic<uint64_t> cons_head_ { 0 };
+    std::atomic<uint64_t> cons_tail_ { 0 };
+
+    uint64_t capacity_u() const noexcept {
+        return static_cast<uint64_t>(slots_.size());
+    }
+
+    // Reserves up to n slots in [head, limit + capacity_offset).
+    array_ref<T> reserve(std::atomic<uint64_t>& head, std::atomic<uint64_t> const& limit, uint64_t capacity_offset, difference_type n) noexcept
+    {
+        assert(n >= 0);
+
+        uint64_t h = head.load(std::memory_order_relaxed);
+        uint64_t k;
+        do {
+            uint64_t const avail = limit.load(std::memory_order_acquire) + capacity_offset - h;
+            uint64_t const pos = h % capacity_u();
+            k = capacity_u() - pos;
+            if (k > avail)
+                k = avail;
+            if (k > static_cast<uint64_t>(n))
+                k = static_cast<uint64_t>(n);
+            if (k == 0)
+                return {};
+        } while (!head.compare_exchange_weak(h, h + k, std::memory_order_relaxed));
+
+        return slots_.slice(static_cast<difference_type>(h % capacity_u()), static_cast<difference_type>(k));
+    }
+
+    // Publishes a window returned by reserve. Windows are reserved at most
+    // capacity() slots ahead of the tail, so the window starts at the tail iff
+    // the tail maps to the window's first slot.
+    void publish(std::atomic<uint64_t>& tail, array_ref<T> window) noexcept
+    {
+        if (window.empty())
+            return;
+
+        assert(window.data() >= slots_.data() && window.data() + window.size() <= slots_.data() + slots_.size());
+        uint64_t const pos = static_cast<uint64_t>(window.data() - slots_.data());
+
+        // Acquire the earlier windows, so that the release store below
+        // publishes their contents along with this one.
+        uint64_t t = tail.load(std::memory_order_acquire);
+        for (int spins = 0; t % capacity_u() != pos; ++spins) {
+            if (spins < 64) {
+                detail::cpu_relax();
+            } else {
+                std::this_thread::yield();
+            }
+            t = tail.load(std::memory_order_acquire);
+        }
+        tail.store(t + static_cast<uint64_t>(window.size()), std::memory_order_release);
+    }
+
+public:
+    explicit mpmc_queue(array_ref<T> slots) noexcept
+        : slots_(slots)
+    {
+        assert(slots_.size() > 0);
+    }
+
+    mpmc_queue(mpmc_queue const&) = delete;
+    mpmc_queue& operator=(mpmc_queue const&) = delete;
+
+    difference_type capacity() const noexcept {
+        return slots_.size();
+    }
+
+    // Returns the number of published elements. Only approximate if called
+    // concurrently with push or pop operations.
+    difference_type size() const noexcept {
+        uint64_t const h = cons_tail_.load(std::memory_order_acquire);
+        uint64_t const t = prod_tail_.load(std::memory_order_acquire);
+        return static_cast<difference_type>(t - h);
+    }
+
+    bool empty() const noexcept {
+        return size() == 0;
+    }
+
+    // Producer: reserves up to n free slots.
+    array_ref<T> begin_push(difference_type n) noexcept {
+        return reserve(prod_head_, cons_tail_, capacity_u(), n);
+    }
+
+    // Producer: publishes a window returned by begin_push.
+    void end_push(array_ref<T> window) noexcept {
+        publish(prod_tail_, window);
+    }
+
+    // Consumer: reserves up to n filled slots.
+    array_ref<T> begin_pop(difference_type n) noexcept {
+        return reserve(cons_head_, prod_tail_, 0, n);
+    }
+
+    // Consumer: releases a window returned by begin_pop.
+    void end_pop(array_ref<T> window) noexcept {
+        publish(cons_tail_, window);
+    }
+
+    bool try_push(T const& value) noexcept(std::is_nothrow_copy_assignable<T>::value)
+    {
+        auto const w = begin_push(1);
+        if (w.empty())
+            return false;
+        w[0] = value;
+        end_push(w);
+        return true;
+    }
+
+    bool try_pop(T& value) noexcept(std::is_nothrow_move_assignable<T>::value)
+    {
+        auto const w = begin_pop(1);
+        if (w.empty())
+            return false;
+        value = std::move(w[0]);
+        end_pop(w);
+        return true;
+    }
+
+    // Pushes as many elements from the front of items as fit and returns
+    // their number.
+    difference_type push(array_ref<T const> items) noexcept(std::is_nothrow_copy_assignable<T>::value)
+    {
+        difference_type count = 0;
+        for (;;) {
+            auto const w = begin_push(items.size() - count);
+            if (w.empty())
+                return count;
+            std::copy(items.begin() + count, items.begin() + count + w.size(), w.begin());
+            end_push(w);
+            count += w.size();
+        }
+    }
+
+    // Pops up to out.size() elements into the front of out and returns their
+    // number.
+    difference_type pop(array_ref<T> out) noexcept(std::is_nothrow_move_assignable<T>::value)
+    {
+        difference_type count = 0;
+        for (;;) {
+            auto const w = begin_pop(out.size() - count);
+            if (w.empty())
+                return count;
+            std::move(w.begin(), w.end(), out.begin() + count);
+            end_pop(w);
+            count += w.size();
+        }
+    }
+};
+
+} // namespace cxx
+
+//------------------------------------------------------------------------------
+// Copyright 2017 A. Bolz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
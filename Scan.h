@@ -0,0 +1,244 @@
+// Distributed under the MIT license. See the end of the file for details.
+
+#pragma once
+
+#include "ArrayRef.h"
+
+#include <cstdint>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace cxx {
+
+namespace detail {
+
+template <typename T>
+T scan_scalar(T const* src, T* dst, std::ptrdiff_t n, T carry, bool exclusive) noexcept
+{
+    if (exclusive) {
+        for (std::ptrdiff_t i = 0; i < n; ++i) {
+            T const x = src[i];
+            dst[i] = carry;
+            carry = carry + x;
+        }
+    } else {
+        for (std::ptrdiff_t i = 0; i < n; ++i) {
+            carry = carry + src[i];
+            dst[i] = carry;
+        }
+    }
+    return carry;
+}
+
+#if defined(__AVX2__)
+// In-register prefix sum of 8 lanes: log-step shifts within each 128-bit
+// half, then the total of the lower half is added to the upper half.
+inline __m256i scan8(__m256i x) noexcept
+{
+    x = _mm256_add_epi32(x, _mm256_slli_si256(x, 4));
+    x = _mm256_add_epi32(x, _mm256_slli_si256(x, 8));
+    __m256i const lo = _mm256_permutevar8x32_epi32(x, _mm256_set1_epi32(3));
+    return _mm256_add_epi32(x, _mm256_blend_epi32(_mm256_setzero_si256(), lo, 0xF0));
+}
+
+inline __m256 scan8(__m256 x) noexcept
+{
+    x = _mm256_add_ps(x, _mm256_castsi256_ps(_mm256_slli_si256(_mm256_castps_si256(x), 4)));
+    x = _mm256_add_ps(x, _mm256_castsi256_ps(_mm256_slli_si256(_mm256_castps_si256(x), 8)));
+    __m256 const lo = _mm256_permutevar8x32_ps(x, _mm256_set1_epi32(3));
+    return _mm256_add_ps(x, _mm256_blend_ps(_mm256_setzero_ps(), lo, 0xF0));
+}
+
+// Shifts the lanes up by one, shifting in zero.
+inline __m256i shift_lanes(__m256i x) noexcept
+{
+    __m256i const y = _mm256_permutevar8x32_epi32(x, _mm256_setr_epi32(0, 0, 1, 2, 3, 4, 5, 6));
+    return _mm256_blend_epi32(y, _mm256_setzero_si256(), 0x01);
+}
+
+inline __m256 shift_lanes(__m256 x) noexcept
+{
+    __m256 const y = _mm256_permutevar8x32_ps(x, _mm256_setr_epi32(0, 0, 1, 2, 3, 4, 5, 6));
+    return _mm256_blend_ps(y, _mm256_setzero_ps(), 0x01);
+}
+
+inline __m256i vec_load(int32_t const* p) noexcept { return _mm256_loadu_si256(reinterpret_cast<__m256i const*>(p)); }
+inline __m256i vec_load(uint32_t const* p) noexcept { return _mm256_loadu_si256(reinterpret_cast<__m256i const*>(p)); }
+inline __m256 vec_load(float const* p) noexcept { return _mm256_loadu_ps(p); }
+
+inline void vec_store(int32_t* p, __m256i x) noexcept { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), x); }
+inline void vec_store(uint32_t* p, __m256i x) noexcept { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), x); }
+inline void vec_store(float* p, __m256 x) noexcept { _mm256_storeu_ps(p, x); }
+
+inline __m256i vec_set1(int32_t x) noexcept { return _mm256_set1_epi32(x); }
+inline __m256i vec_set1(uint32_t x) noexcept { return _mm256_set1_epi32(static_cast<int32_t>(x)); }
+inline __m256 vec_set1(float x) noexcept { return _mm256_set1_ps(x); }
+
+inline __m256i vec_add(__m256i x, __m256i y) noexcept { return _mm256_add_epi32(x, y); }
+inline __m256 vec_add(__m256 x, __m256 y) noexcept { return _mm256_add_ps(x, y); }
+
+inline __m256i vec_last(__m256i x) noexcept { return _mm256_permutevar8x32_epi32(x, _mm256_set1_epi32(7)); }
+inline __m256 vec_last(__m256 x) noexcept { return _mm256_permutevar8x32_ps(x, _mm256_set1_epi32(7)); }
+
+inline int32_t vec_first(__m256i x, int32_t) noexcept { return _mm256_cvtsi256_si32(x); }
+inline uint32_t vec_first(__m256i x, uint32_t) noexcept { return static_cast<uint32_t>(_mm256_cvtsi256_si32(x)); }
+inline float vec_first(__m256 x, float) noexcept { return _mm256_cvtss_f32(x); }
+
+template <typename T>
+using has_simd_scan = std::integral_constant<bool,
+    std::is_same<T, int32_t>::value || std::is_same<T, uint32_t>::value || std::is_same<T, float>::value>;
+
+template <typename T>
+T scan_simd(T const* src, T* dst, std::ptrdiff_t n, T carry, bool exclusive) noexcept
+{
+    auto c = vec_set1(carry);
+
+    std::ptrdiff_t i = 0;
+    for ( ; i + 8 <= n; i += 8) {
+        auto const x = vec_load(src + i);
+        auto const p = scan8(x);
+        vec_store(dst + i, vec_add(c, exclusive ? shift_lanes(p) : p));
+        c = vec_last(vec_add(c, p));
+    }
+
+    return scan_scalar(src + i, dst + i, n - i, vec_first(c, T{}), exclusive);
+}
+#endif
+
+template <typename T>
+T scan(T const* src, T* dst, std::ptrdiff_t n, T carry, bool exclusive) noexcept
+{
+#if defined(__AVX2__)
+    if constexpr (has_simd_scan<T>::value)
+        return scan_simd(src, dst, n, carry, exclusive);
+#endif
+    return scan_scalar(src, dst, n, carry, exclusive);
+}
+
+template <typename T>
+T sum(T const* src, std::ptrdiff_t n) noexcept
+{
+    T s = T{};
+    for (std::ptrdiff_t i = 0; i < n; ++i)
+        s = s + src[i];
+    return s;
+}
+
+template <typename T>
+void parallel_scan(T const* src, T* dst, std::ptrdiff_t n, T init, bool exclusive, int num_threads)
+{
+    if (num_threads <= 0)
+        num_threads = static_cast<int>(std::thread::hardware_concurrency());
+
+    // Below this many elements per thread the scan is memory bound on a
+    // single core and the threads do not pay off.
+    constexpr std::ptrdiff_t min_chunk = 64 * 1024;
+    if (n / min_chunk < num_threads)
+        num_threads = static_cast<int>(n / min_chunk);
+
+    if (num_threads <= 1) {
+        scan(src, dst, n, init, exclusive);
+        return;
+    }
+
+    std::ptrdiff_t const chunk = (n + num_threads - 1) / num_threads;
+    auto const first = [&](int t) { return t * chunk < n ? t * chunk : n; };
+
+    // Pass 1: sum each chunk. Pass 2: scan each chunk, starting with the sum
+    // of all chunks before it. The calling thread handles chunk 0.
+    std::vector<T> sums(static_cast<std::size_t>(num_threads));
+    std::vector<std::thread> threads;
+    threads.reserve(static_cast<std::size_t>(num_threads - 1));
+
+    for (int t = 1; t < num_threads; ++t) {
+        threads.emplace_back([&, t] {
+            sums[t] = sum(src + first(t), first(t + 1) - first(t));
+        });
+    }
+    sums[0] = sum(src, first(1));
+    for (auto& th : threads)
+        th.join();
+    threads.clear();
+
+    T carry = init;
+    for (int t = 0; t < num_threads; ++t) {
+        T const s = sums[t];
+        sums[t] = carry;
+        carry = carry + s;
+    }
+
+    for (int t = 1; t < num_threads; ++t) {
+        threads.emplace_back([&, t] {
+            scan(src + first(t), dst + first(t), first(t + 1) - first(t), sums[t], exclusive);
+        });
+    }
+    scan(src, dst, first(1), sums[0], exclusive);
+    for (auto& th : threads)
+        th.join();
+}
+
+} // namespace detail
+
+// dst[i] = init + src[0] + ... + src[i]
+//
+// src and dst may be the same array. For float, the SIMD kernel adds in a
+// different order than a sequential loop, so results may differ in the last
+// bits.
+template <typename T>
+void inclusive_scan(array_ref<std::add_const_t<T>> src, array_ref<T> dst, typename array_ref<T>::value_type init = {}) noexcept
+{
+    assert(dst.size() >= src.size());
+    detail::scan<T>(src.data(), dst.data(), src.size(), init, false);
+}
+
+// dst[i] = init + src[0] + ... + src[i - 1]
+template <typename T>
+void exclusive_scan(array_ref<std::add_const_t<T>> src, array_ref<T> dst, typename array_ref<T>::value_type init = {}) noexcept
+{
+    assert(dst.size() >= src.size());
+    detail::scan<T>(src.data(), dst.data(), src.size(), init, true);
+}
+
+// Like inclusive_scan, but splits large inputs across num_threads threads
+// (0 = hardware concurrency) using a reduce-then-scan scheme.
+template <typename T>
+void parallel_inclusive_scan(array_ref<std::add_const_t<T>> src, array_ref<T> dst, typename array_ref<T>::value_type init = {}, int num_threads = 0)
+{
+    assert(dst.size() >= src.size());
+    detail::parallel_scan<T>(src.data(), dst.data(), src.size(), init, false, num_threads);
+}
+
+template <typename T>
+void parallel_exclusive_scan(array_ref<std::add_const_t<T>> src, array_ref<T> dst, typename array_ref<T>::value_type init = {}, int num_threads = 0)
+{
+    assert(dst.size() >= src.size());
+    detail::parallel_scan<T>(src.data(), dst.data(), src.size(), init, true, num_threads);
+}
+
+} // namespace cxx
+
+//------------------------------------------------------------------------------
+// Copyright 2017 A. Bolz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
@@ -0,0 +1,227 @@
+// Distributed under the MIT license. See the end of the file for details.
+
+#pragma once
+
+#include "ArrayRef.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+#if defined(__AVX2__) && defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+namespace cxx {
+
+namespace detail {
+
+template <typename CharT>
+using is_byte_like = std::integral_constant<bool,
+    std::is_same<std::remove_const_t<CharT>, char>::value ||
+    std::is_same<std::remove_const_t<CharT>, unsigned char>::value ||
+    std::is_same<std::remove_const_t<CharT>, std::byte>::value>;
+
+using byte_ptr = unsigned char const*;
+
+#if defined(__AVX2__)
+inline __m256i load32(byte_ptr p) noexcept
+{
+    return _mm256_loadu_si256(reinterpret_cast<__m256i const*>(p));
+}
+
+inline int ctz32(uint32_t m) noexcept
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long i;
+    _BitScanForward(&i, m);
+    return static_cast<int>(i);
+#else
+    return __builtin_ctz(m);
+#endif
+}
+#endif
+
+// The functions below return the index of the match, or n.
+
+inline std::ptrdiff_t find_byte(byte_ptr p, std::ptrdiff_t n, unsigned char c) noexcept
+{
+#if defined(__AVX2__)
+    __m256i const v = _mm256_set1_epi8(static_cast<char>(c));
+    std::ptrdiff_t i = 0;
+    for ( ; i + 32 <= n; i += 32) {
+        auto const m = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(load32(p + i), v)));
+        if (m != 0)
+            return i + ctz32(m);
+    }
+    for ( ; i < n; ++i) {
+        if (p[i] == c)
+            return i;
+    }
+    return n;
+#else
+    auto const q = n > 0 ? static_cast<byte_ptr>(std::memchr(p, c, static_cast<std::size_t>(n))) : nullptr;
+    return q ? q - p : n;
+#endif
+}
+
+// A set of bytes, stored as a 256-bit table and, for the SIMD path, split
+// into nibble lookup tables: byte x = (hi << 4) | lo is in the set iff
+// bit (hi % 8) of lo_tables[hi / 8][lo] is set.
+struct byte_set
+{
+    bool table[256] = {};
+    alignas(16) uint8_t lo_tables[2][16] = {};
+
+    explicit byte_set(byte_ptr set, std::ptrdiff_t n) noexcept
+    {
+        for (std::ptrdiff_t i = 0; i < n; ++i) {
+            unsigned char const c = set[i];
+            table[c] = true;
+            lo_tables[c >> 7][c & 0x0F] |= static_cast<uint8_t>(1u << ((c >> 4) & 7));
+        }
+    }
+};
+
+inline std::ptrdiff_t find_any_of(byte_ptr p, std::ptrdiff_t n, byte_set const& set) noexcept
+{
+    std::ptrdiff_t i = 0;
+
+#if defined(__AVX2__)
+    __m256i const lo_a = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<__m128i const*>(set.lo_tables[0])));
+    __m256i const lo_b = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<__m128i const*>(set.lo_tables[1])));
+    __m256i const hi_bits = _mm256_setr_epi8(
+        1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128,
+        1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+    __m256i const nibble = _mm256_set1_epi8(0x0F);
+
+    for ( ; i + 32 <= n; i += 32) {
+        __m256i const x = load32(p + i);
+        __m256i const lo = _mm256_and_si256(x, nibble);
+        __m256i const hi = _mm256_and_si256(_mm256_srli_epi16(x, 4), nibble);
+        __m256i const rows = _mm256_blendv_epi8(_mm256_shuffle_epi8(lo_a, lo), _mm256_shuffle_epi8(lo_b, lo), x);
+        __m256i const hit = _mm256_and_si256(rows, _mm256_shuffle_epi8(hi_bits, hi));
+        auto const m = ~static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(hit, _mm256_setzero_si256())));
+        if (m != 0)
+            return i + ctz32(m);
+    }
+#endif
+
+    for ( ; i < n; ++i) {
+        if (set.table[p[i]])
+            return i;
+    }
+    return n;
+}
+
+// Finds candidate positions by comparing the first and the last byte of the
+// needle 32 positions at a time, and only compares the bytes in between for
+// those.
+inline std::ptrdiff_t search(byte_ptr p, std::ptrdiff_t n, byte_ptr needle, std::ptrdiff_t k) noexcept
+{
+    if (k == 0)
+        return 0;
+    if (k > n)
+        return n;
+    if (k == 1)
+        return find_byte(p, n, needle[0]);
+
+    std::ptrdiff_t i = 0;
+    std::ptrdiff_t const last = n - k; // last candidate position
+
+#if defined(__AVX2__)
+    __m256i const first_byte = _mm256_set1_epi8(static_cast<char>(needle[0]));
+    __m256i const last_byte = _mm256_set1_epi8(static_cast<char>(needle[k - 1]));
+
+    for ( ; i + 32 <= last + 1; i += 32) {
+        __m256i const f = _mm256_cmpeq_epi8(load32(p + i), first_byte);
+        __m256i const l = _mm256_cmpeq_epi8(load32(p + i + k - 1), last_byte);
+        auto m = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_and_si256(f, l)));
+        for ( ; m != 0; m &= m - 1) {
+            std::ptrdiff_t const j = i + ctz32(m);
+            if (std::memcmp(p + j + 1, needle + 1, static_cast<std::size_t>(k - 2)) == 0)
+                return j;
+        }
+    }
+#endif
+
+    while (i <= last) {
+        std::ptrdiff_t const j = i + find_byte(p + i, last + 1 - i, needle[0]);
+        if (j > last)
+            break;
+        if (p[j + k - 1] == needle[k - 1] && std::memcmp(p + j + 1, needle + 1, static_cast<std::size_t>(k - 2)) == 0)
+            return j;
+        i = j + 1;
+    }
+    return n;
+}
+
+template <typename CharT>
+byte_ptr as_byte_ptr(CharT* p) noexcept
+{
+    return reinterpret_cast<byte_ptr>(p);
+}
+
+} // namespace detail
+
+// Returns the part of arr starting at the first occurrence of c, or an empty
+// array at the end of arr if c does not occur.
+template <
+    typename CharT,
+    typename = std::enable_if_t< detail::is_byte_like<CharT>::value >
+>
+array_ref<CharT> find_byte(array_ref<CharT> arr, std::remove_const_t<CharT> c) noexcept
+{
+    return arr.drop_front(detail::find_byte(detail::as_byte_ptr(arr.data()), arr.size(), static_cast<unsigned char>(c)));
+}
+
+// Returns the part of arr starting at the first byte which is contained in
+// set, or an empty array at the end of arr if there is none.
+template <
+    typename CharT,
+    typename = std::enable_if_t< detail::is_byte_like<CharT>::value >
+>
+array_ref<CharT> find_any_of(array_ref<CharT> arr, array_ref<std::add_const_t<CharT>> set) noexcept
+{
+    detail::byte_set const s(detail::as_byte_ptr(set.data()), set.size());
+    return arr.drop_front(detail::find_any_of(detail::as_byte_ptr(arr.data()), arr.size(), s));
+}
+
+// Returns the first occurrence of needle in arr, or an empty array at the
+// end of arr if there is none.
+template <
+    typename CharT,
+    typename = std::enable_if_t< detail::is_byte_like<CharT>::value >
+>
+array_ref<CharT> search(array_ref<CharT> arr, array_ref<std::add_const_t<CharT>> needle) noexcept
+{
+    auto const i = detail::search(detail::as_byte_ptr(arr.data()), arr.size(), detail::as_byte_ptr(needle.data()), needle.size());
+    return arr.slice(i, needle.size());
+}
+
+} // namespace cxx
+
+//------------------------------------------------------------------------------
+// Copyright 2017 A. Bolz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
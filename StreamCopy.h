@@ -0,0 +1,192 @@
+// Distributed under the MIT license. See the end of the file for details.
+
+#pragma once
+
+#include "ArrayRef.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CXX_STREAM_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(__linux__)
+#include <unistd.h>
+#endif
+
+namespace cxx {
+
+namespace detail {
+
+inline std::ptrdiff_t last_level_cache_size() noexcept
+{
+#if defined(__linux__) && defined(_SC_LEVEL3_CACHE_SIZE)
+    long const l3 = sysconf(_SC_LEVEL3_CACHE_SIZE);
+    if (l3 > 0)
+        return l3;
+    long const l2 = sysconf(_SC_LEVEL2_CACHE_SIZE);
+    if (l2 > 0)
+        return l2;
+#endif
+    return 8 * 1024 * 1024;
+}
+
+inline std::atomic<std::ptrdiff_t>& stream_threshold_storage() noexcept
+{
+    static std::atomic<std::ptrdiff_t> threshold { last_level_cache_size() / 2 };
+    return threshold;
+}
+
+#if CXX_STREAM_SSE2
+// Copies n bytes using non-temporal stores. dst must be 16-byte aligned and
+// n must be a multiple of 64.
+inline void stream_copy_aligned(char* dst, char const* src, std::ptrdiff_t n) noexcept
+{
+    for (std::ptrdiff_t i = 0; i < n; i += 64) {
+        __m128i const x0 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + i));
+        __m128i const x1 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + i + 16));
+        __m128i const x2 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + i + 32));
+        __m128i const x3 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + i + 48));
+        _mm_stream_si128(reinterpret_cast<__m128i*>(dst + i), x0);
+        _mm_stream_si128(reinterpret_cast<__m128i*>(dst + i + 16), x1);
+        _mm_stream_si128(reinterpret_cast<__m128i*>(dst + i + 32), x2);
+        _mm_stream_si128(reinterpret_cast<__m128i*>(dst + i + 48), x3);
+    }
+}
+
+// Fills n bytes with the 16-byte pattern using non-temporal stores. dst must
+// be 16-byte aligned and n must be a multiple of 64.
+inline void stream_fill_aligned(char* dst, __m128i pattern, std::ptrdiff_t n) noexcept
+{
+    for (std::ptrdiff_t i = 0; i < n; i += 64) {
+        _mm_stream_si128(reinterpret_cast<__m128i*>(dst + i), pattern);
+        _mm_stream_si128(reinterpret_cast<__m128i*>(dst + i + 16), pattern);
+        _mm_stream_si128(reinterpret_cast<__m128i*>(dst + i + 32), pattern);
+        _mm_stream_si128(reinterpret_cast<__m128i*>(dst + i + 48), pattern);
+    }
+}
+#endif
+
+} // namespace detail
+
+// Returns the size in bytes above which stream_copy and stream_fill bypass
+// the cache. Defaults to half the size of the last level cache.
+inline std::ptrdiff_t stream_threshold() noexcept
+{
+    return detail::stream_threshold_storage().load(std::memory_order_relaxed);
+}
+
+inline void set_stream_threshold(std::ptrdiff_t bytes) noexcept
+{
+    assert(bytes >= 0);
+    detail::stream_threshold_storage().store(bytes, std::memory_order_relaxed);
+}
+
+// Copies src into the front of dst. Uses non-temporal stores if the size of
+// src in bytes is at least threshold. The arrays must not overlap.
+template <typename T>
+void stream_copy(array_ref<T> dst, array_ref<std::add_const_t<T>> src, std::ptrdiff_t threshold) noexcept
+{
+    static_assert(std::is_trivially_copyable<T>::value, "invalid template argument");
+
+    assert(dst.size() >= src.size());
+    assert(dst.data() + src.size() <= src.data() || src.data() + src.size() <= dst.data());
+
+    std::ptrdiff_t n = src.size_in_bytes();
+    if (n == 0)
+        return;
+
+    auto d = reinterpret_cast<char*>(dst.data());
+    auto s = reinterpret_cast<char const*>(src.data());
+
+#if CXX_STREAM_SSE2
+    if (n >= threshold && n >= 128) {
+        std::ptrdiff_t const head = static_cast<std::ptrdiff_t>((16 - reinterpret_cast<uintptr_t>(d) % 16) % 16);
+        std::memcpy(d, s, static_cast<size_t>(head));
+        d += head;
+        s += head;
+        n -= head;
+
+        std::ptrdiff_t const body = n & ~std::ptrdiff_t{63};
+        detail::stream_copy_aligned(d, s, body);
+        _mm_sfence();
+
+        std::memcpy(d + body, s + body, static_cast<size_t>(n - body));
+        return;
+    }
+#endif
+
+    std::memcpy(d, s, static_cast<size_t>(n));
+}
+
+template <typename T>
+void stream_copy(array_ref<T> dst, array_ref<std::add_const_t<T>> src) noexcept
+{
+    stream_copy<T>(dst, src, stream_threshold());
+}
+
+// Sets all elements of dst to value. Uses non-temporal stores if the size of
+// dst in bytes is at least threshold.
+template <typename T>
+void stream_fill(array_ref<T> dst, typename array_ref<T>::value_type const& value, std::ptrdiff_t threshold) noexcept
+{
+    static_assert(std::is_trivially_copyable<T>::value, "invalid template argument");
+
+#if CXX_STREAM_SSE2
+    // The 16-byte pattern must start on an element boundary.
+    if (16 % sizeof(T) == 0 && dst.size_in_bytes() >= threshold && dst.size_in_bytes() >= 128
+        && reinterpret_cast<uintptr_t>(dst.data()) % sizeof(T) == 0)
+    {
+        std::ptrdiff_t const head_bytes = static_cast<std::ptrdiff_t>((16 - reinterpret_cast<uintptr_t>(dst.data()) % 16) % 16);
+        std::ptrdiff_t const head = head_bytes / static_cast<std::ptrdiff_t>(sizeof(T));
+        std::fill(dst.data(), dst.data() + head, value);
+        dst = dst.drop_front(head);
+
+        alignas(16) unsigned char pattern[16];
+        for (size_t i = 0; i < 16; i += sizeof(T))
+            std::memcpy(pattern + i, &value, sizeof(T));
+
+        std::ptrdiff_t const body = dst.size_in_bytes() & ~std::ptrdiff_t{63};
+        detail::stream_fill_aligned(reinterpret_cast<char*>(dst.data()), _mm_load_si128(reinterpret_cast<__m128i const*>(pattern)), body);
+        _mm_sfence();
+
+        dst = dst.drop_front(body / static_cast<std::ptrdiff_t>(sizeof(T)));
+    }
+#endif
+
+    std::fill(dst.data(), dst.data() + dst.size(), value);
+}
+
+template <typename T>
+void stream_fill(array_ref<T> dst, typename array_ref<T>::value_type const& value) noexcept
+{
+    stream_fill<T>(dst, value, stream_threshold());
+}
+
+} // namespace cxx
+
+//------------------------------------------------------------------------------
+// Copyright 2017 A. Bolz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
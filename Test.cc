@@ -1,8 +1,43 @@
 #include "ArrayRef.h"
+#include "IndexedView.h"
+#include "Prefetch.h"
+#include "StreamCopy.h"
+#include "Queue.h"
+#include "ChainRef.h"
+#include "PackedArrayRef.h"
+#include "BlockReader.h"
+#include "GatherWrite.h"
+#include "Hash.h"
+#include "Tiling.h"
+#include "Views.h"
+#include "Scan.h"
+#include "Compact.h"
+#include "Histogram.h"
+#include "UntypedArrayRef.h"
+#include "BitArrayRef.h"
+#include "Search.h"
+#include "Lines.h"
+#include "Csv.h"
+#include "Algorithm.h"
+#include "PerfectHash.h"
+#include "HugePages.h"
+#include "Parallel.h"
+#include "AtomicArrayRef.h"
 
 #include <array>
 #include <algorithm>
 #include <vector>
+#include <cstdint>
+#include <atomic>
+#include <thread>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <numeric>
+#include <functional>
+#include <string_view>
+#include <stdexcept>
 
 static void func(cxx::array_ref<int>) {}
 static void func_const(cxx::array_ref<const int>) {}
@@ -140,5 +175,1112 @@ int main()
         //AV av1 = arr; // ERROR
         AVC av2 = arr;
     }
-}
 
+    {
+        std::vector<int> data(1000);
+        for (int i = 0; i < 1000; ++i)
+            data[i] = i * 3;
+        std::vector<uint32_t> idx(333);
+        for (int i = 0; i < 333; ++i)
+            idx[i] = static_cast<uint32_t>((i * 7919) % 1000);
+
+        cxx::indexed_view<const int> iv(data, idx);
+        assert(iv.size() == 333);
+        assert(iv[5] == data[idx[5]]);
+        assert(*(iv.begin() + 7) == data[idx[7]]);
+        assert(iv.end() - iv.begin() == 333);
+        assert(std::equal(iv.slice(10, 5).begin(), iv.slice(10, 5).end(), iv.begin() + 10));
+
+        std::vector<int> out(333);
+        cxx::gather(out, iv);
+        for (int i = 0; i < 333; ++i)
+            assert(out[i] == data[idx[i]]);
+
+        std::vector<double> ddata(data.begin(), data.end());
+        std::vector<double> dout(333);
+        cxx::gather(dout, cxx::array_ref<const double>(ddata), idx);
+        for (int i = 0; i < 333; ++i)
+            assert(dout[i] == data[idx[i]]);
+
+        std::vector<int> back(1000, -1);
+        cxx::scatter(cxx::indexed_view<int>(back, idx), out);
+        for (int i = 0; i < 333; ++i)
+            assert(back[idx[i]] == out[i]);
+    }
+
+    {
+        struct Node { int value; };
+        std::vector<Node> nodes(100);
+        std::vector<Node*> ptrs(100);
+        std::vector<uint32_t> idx(100);
+        for (int i = 0; i < 100; ++i) {
+            nodes[i].value = i;
+            ptrs[i] = &nodes[99 - i];
+            idx[i] = static_cast<uint32_t>(99 - i);
+        }
+
+        int sum = 0;
+        for (Node* p : cxx::prefetch_pointees(cxx::array_ref<Node*>(ptrs), 8))
+            sum += p->value;
+        assert(sum == 4950);
+
+        auto r = cxx::prefetch_indexed_elements(cxx::array_ref<const uint32_t>(idx), cxx::array_ref<Node>(nodes), 4);
+        r.set_distance(200);
+        assert(r.distance() == 200);
+        sum = 0;
+        for (uint32_t i : r)
+            sum += nodes[i].value;
+        assert(sum == 4950);
+
+        auto e = cxx::prefetch_elements(cxx::array_ref<Node>(nodes), 0);
+        assert(e.end() - e.begin() == 100);
+        assert((e.begin() + 3)->value == 3);
+
+        // Distance 0 issues no prefetches.
+        int prefetches = 0;
+        auto const count = [&](Node const& n) -> void const* { ++prefetches; return &n; };
+        for (int d : { 0, 4 }) {
+            prefetches = 0;
+            cxx::prefetch_range<Node, decltype(count)> c(nodes, d, count);
+            sum = 0;
+            for (Node const& n : c)
+                sum += n.value;
+            assert(sum == 4950);
+            assert(prefetches == (d == 0 ? 0 : 100));
+        }
+    }
+
+    {
+        std::vector<uint8_t> src(100000), dst(100000);
+        for (size_t i = 0; i < src.size(); ++i)
+            src[i] = static_cast<uint8_t>(i * 31);
+
+        cxx::array_ref<uint8_t> d = dst;
+        cxx::array_ref<const uint8_t> s = src;
+        cxx::stream_copy(d.drop_front(3), s.slice(5, 90000), 0);
+        assert(std::equal(src.begin() + 5, src.begin() + 90005, dst.begin() + 3));
+        cxx::stream_copy(d, s);
+        assert(src == dst);
+
+        std::vector<uint16_t> v(5001, 0);
+        cxx::stream_fill(cxx::array_ref<uint16_t>(v).drop_front(1), 0xABCD, 0);
+        assert(v[0] == 0);
+        assert(std::all_of(v.begin() + 1, v.end(), [](uint16_t x) { return x == 0xABCD; }));
+
+        auto const old = cxx::stream_threshold();
+        cxx::set_stream_threshold(1);
+        assert(cxx::stream_threshold() == 1);
+        cxx::set_stream_threshold(old);
+    }
+
+    {
+        std::vector<int> storage(7);
+        cxx::spsc_queue<int> q(storage);
+        assert(q.capacity() == 7);
+
+        int const items[5] = {1, 2, 3, 4, 5};
+        assert(q.push(items) == 5);
+        assert(q.push(items) == 2);
+        assert(q.size() == 7);
+        int x = 0;
+        assert(!q.try_push(0));
+        assert(q.try_pop(x) && x == 1);
+
+        auto w = q.begin_pop(100);
+        assert(w.size() == 6);
+        q.end_pop(w);
+        assert(q.empty());
+
+        // Windows stop at the wrap-around point.
+        assert(q.push(items) == 5);
+        w = q.begin_push(100);
+        assert(w.size() == 2);
+        q.end_push(w);
+        int out[8];
+        assert(q.pop(out) == 7);
+        assert(out[0] == 1 && out[4] == 5);
+        assert(q.empty());
+
+        // The cached indices are refreshed whenever they would shorten the
+        // window, not only when the queue looks full resp. empty.
+        std::vector<int> storage2(8);
+        cxx::spsc_queue<int> q2(storage2);
+        q2.end_push(q2.begin_push(8));
+        q2.end_pop(q2.begin_pop(2));
+        q2.end_push(q2.begin_push(1));
+        q2.end_pop(q2.begin_pop(6));
+        assert(q2.begin_push(4).size() == 4);
+        q2.end_push(4);
+        q2.end_pop(q2.begin_pop(1));
+        q2.end_push(q2.begin_push(3));
+        assert(q2.begin_pop(7).size() == 7);
+
+        constexpr int N = 20000;
+        std::thread producer([&] {
+            for (int i = 1; i <= N; ) {
+                auto w = q.begin_push(N - i + 1 < 3 ? N - i + 1 : 3);
+                if (w.empty())
+                    std::this_thread::yield();
+                for (auto& s : w)
+                    s = i++;
+                q.end_push(w);
+            }
+        });
+        long long sum = 0;
+        int expected = 1;
+        for (int got = 0; got < N; ) {
+            int buf[4];
+            auto const n = q.pop(buf);
+            if (n == 0)
+                std::this_thread::yield();
+            for (int i = 0; i < n; ++i) {
+                assert(buf[i] == expected);
+                ++expected;
+                sum += buf[i];
+            }
+            got += static_cast<int>(n);
+        }
+        producer.join();
+        assert(sum == static_cast<long long>(N) * (N + 1) / 2);
+    }
+
+    {
+        std::vector<int> storage(64);
+        cxx::mpmc_queue<int> q(storage);
+
+        constexpr int N = 10000;
+        std::atomic<long long> sum { 0 };
+        std::atomic<int> popped { 0 };
+        auto produce = [&] {
+            for (int i = 1; i <= N; ) {
+                auto w = q.begin_push(N - i + 1 < 5 ? N - i + 1 : 5);
+                if (w.empty())
+                    std::this_thread::yield();
+                for (auto& s : w)
+                    s = i++;
+                q.end_push(w);
+            }
+        };
+        auto consume = [&] {
+            while (popped.load() < 2 * N) {
+                auto w = q.begin_pop(4);
+                if (w.empty())
+                    std::this_thread::yield();
+                for (int v : w)
+                    sum += v;
+                q.end_pop(w);
+                popped += static_cast<int>(w.size());
+            }
+        };
+        std::thread threads[] = {
+            std::thread(produce), std::thread(produce), std::thread(consume), std::thread(consume),
+        };
+        for (auto& t : threads)
+            t.join();
+        assert(q.empty());
+        assert(sum == static_cast<long long>(N) * (N + 1));
+    }
+
+    {
+        // Several producers, one consumer: each producer's values must arrive
+        // complete and in order, whichever thread published the tail.
+        std::vector<uint32_t> storage(32);
+        cxx::mpmc_queue<uint32_t> q(storage);
+
+        constexpr int P = 3;
+        constexpr uint32_t N = 20000;
+        auto produce = [&](uint32_t p) {
+            for (uint32_t i = 0; i < N; ) {
+                auto w = q.begin_push(N - i < 3 ? N - i : 3);
+                if (w.empty())
+                    std::this_thread::yield();
+                for (auto& s : w)
+                    s = (p << 24) | i++;
+                q.end_push(w);
+            }
+        };
+        std::thread producers[] = {
+            std::thread(produce, 0u), std::thread(produce, 1u), std::thread(produce, 2u),
+        };
+        uint32_t next[P] = {};
+        for (uint32_t got = 0; got < P * N; ) {
+            uint32_t buf[8];
+            auto const n = q.pop(buf);
+            if (n == 0)
+                std::this_thread::yield();
+            for (std::ptrdiff_t i = 0; i < n; ++i) {
+                uint32_t const p = buf[i] >> 24;
+                assert(p < P);
+                assert((buf[i] & 0xFFFFFF) == next[p]);
+                ++next[p];
+            }
+            got += static_cast<uint32_t>(n);
+        }
+        for (auto& t : producers)
+            t.join();
+        assert(next[0] == N && next[1] == N && next[2] == N);
+        assert(q.empty());
+    }
+
+    {
+        int a[] = {1, 2, 3};
+        int b[] = {4};
+        int c[] = {5, 6};
+        cxx::array_ref<const int> const segs[] = { a, {}, b, c, {} };
+        cxx::chain_ref<const int> chain(segs);
+
+        assert(chain.size() == 6);
+        assert(!chain.empty());
+        assert(std::distance(chain.begin(), chain.end()) == 6);
+        int expected = 1;
+        for (int x : chain)
+            assert(x == expected++);
+        assert(*--chain.end() == 6);
+
+        int out[8] = {};
+        auto rest = cxx::copy(chain, out);
+        assert(rest.size() == 2);
+        assert(out[0] == 1 && out[5] == 6);
+
+        auto it = cxx::find(chain, 4);
+        assert(it != chain.end() && *it == 4);
+        assert(*++it == 5);
+        assert(cxx::find(chain, 7) == chain.end());
+
+        assert(cxx::reduce(chain, 0) == 21);
+        assert(cxx::reduce(chain, 1, [](int x, int y) { return x * y; }) == 720);
+
+        cxx::array_ref<const int> const one[] = { cxx::array_ref<const int>(out).take_front(6) };
+        assert(cxx::hash(chain) == cxx::hash(cxx::chain_ref<const int>(one)));
+
+        cxx::array_ref<const int> const none[] = { {}, {} };
+        assert(cxx::chain_ref<const int>(none).empty());
+        assert(cxx::chain_ref<const int>(none).begin() == cxx::chain_ref<const int>(none).end());
+    }
+
+    {
+        constexpr int N = 1000;
+        using P20 = cxx::packed_array_ref<20>;
+        std::vector<uint64_t> words(P20::words_for(N));
+        P20 p(words, N);
+        assert(p.size() == N);
+
+        std::vector<uint32_t> values(N);
+        for (int i = 0; i < N; ++i)
+            values[i] = static_cast<uint32_t>(i * 2654435761u) & 0xFFFFF;
+
+        cxx::pack(values, p);
+        for (int i = 0; i < N; ++i)
+            assert(p[i] == values[i]);
+
+        p[3] = 12345;
+        assert(p[3] == 12345);
+        assert(p[2] == values[2] && p[4] == values[4]);
+        p[3] = values[3];
+
+        std::vector<uint32_t> out(N);
+        cxx::unpack(p, out);
+        assert(out == values);
+
+        // Unaligned sub-views.
+        cxx::packed_array_ref<20, const uint64_t> cp = p.slice(13, 500);
+        assert(cp.size() == 500);
+        assert(cp[0] == values[13]);
+        assert(*(cp.end() - 1) == values[512]);
+        std::fill(out.begin(), out.end(), 0);
+        cxx::unpack(cp, out);
+        assert(std::equal(out.begin(), out.begin() + 500, values.begin() + 13));
+
+        std::vector<uint32_t> small(77, 1);
+        cxx::pack(small, p.slice(101, 77));
+        assert(p[100] == values[100] && p[101] == 1 && p[177] == 1 && p[178] == values[178]);
+
+        std::vector<uint64_t> w7(cxx::packed_array_ref<7>::words_for(100));
+        cxx::packed_array_ref<7> p7(w7);
+        assert(p7.size() == static_cast<std::ptrdiff_t>(w7.size()) * 64 / 7);
+        for (auto&& x : p7)
+            x = 127;
+        assert(std::all_of(p7.begin(), p7.end(), [](uint32_t x) { return x == 127; }));
+    }
+
+    {
+        // Bit widths which divide 64 take the SIMD path, if available, from
+        // the first word boundary on.
+        auto const check_pack = [](auto bits) {
+            constexpr unsigned B = decltype(bits)::value;
+            constexpr uint32_t mask = static_cast<uint32_t>((uint64_t{1} << B) - 1);
+            constexpr int N = 1500;
+            std::vector<uint32_t> values(N);
+            for (int i = 0; i < N; ++i)
+                values[i] = static_cast<uint32_t>(i * 2654435761u) & mask;
+
+            std::vector<uint64_t> words(cxx::packed_array_ref<B>::words_for(N + 8));
+            cxx::packed_array_ref<B> p(words, N + 8);
+            for (int offset : { 0, 3 }) {
+                for (int n : { 0, 1, 63, 257, N }) {
+                    for (auto&& x : p)
+                        x = mask;
+                    cxx::pack(cxx::array_ref<uint32_t const>(values).take_front(n), p.slice(offset, n));
+                    for (int i = 0; i < n; ++i)
+                        assert(p[offset + i] == values[i]);
+                    assert(offset == 0 || p[offset - 1] == mask);
+                    assert(p[offset + n] == mask);
+                }
+            }
+        };
+        check_pack(std::integral_constant<unsigned, 1>{});
+        check_pack(std::integral_constant<unsigned, 2>{});
+        check_pack(std::integral_constant<unsigned, 4>{});
+        check_pack(std::integral_constant<unsigned, 8>{});
+        check_pack(std::integral_constant<unsigned, 16>{});
+        check_pack(std::integral_constant<unsigned, 32>{});
+        check_pack(std::integral_constant<unsigned, 12>{});
+    }
+
+    {
+        struct Record { int32_t key; int32_t value; int16_t flags; };
+        constexpr int N = 1037;
+
+        FILE* f = std::tmpfile();
+        assert(f != nullptr);
+        for (int i = 0; i < N; ++i) {
+            Record r = { i, i * 2, static_cast<int16_t>(i & 0xFF) };
+            std::fwrite(&r, sizeof(r), 1, f);
+        }
+        std::fwrite("xy", 1, 2, f); // trailing partial record
+        std::fflush(f);
+
+        for (bool read_ahead : { false, true }) {
+            // The block size does not divide the number of records.
+            cxx::block_reader<Record> reader(fileno(f), 100 * sizeof(Record), read_ahead, 0);
+            int expected = 0;
+            for (;;) {
+                auto block = reader.next();
+                if (block.empty())
+                    break;
+                assert(block.size() <= 100 && reader.block_size() == 100);
+                for (auto const& r : block) {
+                    assert(r.key == expected && r.value == expected * 2);
+                    ++expected;
+                }
+            }
+            assert(expected == N);
+            assert(reader.error() == 0);
+            assert(reader.next().empty());
+        }
+
+        // Start at an offset, with small blocks.
+        cxx::block_reader<Record> reader(fileno(f), 7 * sizeof(Record), true, sizeof(Record) * 1000);
+        int count = 0;
+        for (auto block = reader.next(); !block.empty(); block = reader.next())
+            count += static_cast<int>(block.size());
+        assert(count == N - 1000);
+
+        std::fclose(f);
+
+        // Short reads, and blocks which are not a multiple of the record
+        // size, so that records are split across reads and blocks.
+        std::vector<char> bytes(N * sizeof(Record) + 2);
+        for (int i = 0; i < N; ++i) {
+            Record r = { i, i * 2, static_cast<int16_t>(i & 0xFF) };
+            std::memcpy(bytes.data() + i * sizeof(Record), &r, sizeof(r));
+        }
+        auto const source = [&](void* buf, std::size_t n, off_t offset) -> ssize_t {
+            auto const pos = static_cast<std::size_t>(offset);
+            std::size_t const k = std::min({ n, bytes.size() - pos, std::size_t{5} + pos % 7 });
+            std::memcpy(buf, bytes.data() + pos, k);
+            return static_cast<ssize_t>(k);
+        };
+        for (bool read_ahead : { false, true }) {
+            cxx::block_reader<Record, decltype(source)> reader(source, 50, read_ahead);
+            assert(reader.block_size() == 4);
+            int expected = 0;
+            for (auto block = reader.next(); !block.empty(); block = reader.next()) {
+                assert(block.size() <= 4);
+                for (auto const& r : block) {
+                    assert(r.key == expected && r.value == expected * 2 && r.flags == (expected & 0xFF));
+                    ++expected;
+                }
+            }
+            assert(expected == N);
+            assert(reader.error() == 0);
+        }
+    }
+
+    {
+        std::vector<char> header = { 'a', 'b', 'c' };
+        std::vector<uint32_t> payload(3000);
+        for (int i = 0; i < 3000; ++i)
+            payload[i] = static_cast<uint32_t>(i);
+
+        cxx::gather_writer writer;
+        writer.add(cxx::array_ref<const char>(header));
+        for (int i = 0; i < 3000; ++i) // more pieces than IOV_MAX
+            writer.add(cxx::array_ref<const uint32_t>(payload).slice(i, 1));
+        writer.add(cxx::array_ref<const char>());
+        assert(writer.size() == 3 + 3000 * 4);
+
+        FILE* f = std::tmpfile();
+        assert(writer.write(fileno(f)) == 0);
+        assert(writer.empty());
+
+        writer.add(cxx::array_ref<const char>(header).take_front(2));
+        writer.add(cxx::array_ref<const char>(header).take_front(1));
+        assert(writer.write_at(fileno(f), 1) == 0);
+
+        std::vector<char> contents(3 + 3000 * 4);
+        assert(pread(fileno(f), contents.data(), contents.size(), 0) == static_cast<ssize_t>(contents.size()));
+        assert(contents[0] == 'a' && contents[1] == 'a' && contents[2] == 'b' && contents[3] == 'a');
+        auto const bytes = cxx::as_bytes(cxx::array_ref<const uint32_t>(payload));
+        assert(std::memcmp(contents.data() + 4, bytes.data() + 1, bytes.size() - 1) == 0);
+        std::fclose(f);
+
+        // A write which makes no progress fails instead of looping forever.
+        char c = 'x';
+        iovec iov[] = { { &c, 0 }, { &c, 1 } };
+        int calls = 0;
+        auto const stuck = [&](iovec const*, int) -> ssize_t { ++calls; return 0; };
+        assert(cxx::detail::write_iov(iov, stuck) == ENOSPC);
+        assert(calls == 2 && iov[1].iov_len == 1);
+    }
+
+    {
+        std::vector<unsigned char> data(300);
+        for (size_t i = 0; i < data.size(); ++i)
+            data[i] = static_cast<unsigned char>(i * 131 + 7);
+
+        cxx::array_ref<const unsigned char> all = data;
+        for (std::ptrdiff_t len = 0; len <= 300; len += (len < 100 ? 1 : 37)) {
+            auto const bytes = cxx::as_bytes(all.take_front(len));
+            uint64_t const h = cxx::hash_bytes(bytes, 42);
+            assert(h == cxx::hash_contents(all.take_front(len), 42));
+
+            // Split into chunks of varying size.
+            for (std::ptrdiff_t chunk : { 1, 5, 16, 47, 48, 49, 100 }) {
+                cxx::hash_state state(42);
+                for (std::ptrdiff_t i = 0; i < len; i += chunk)
+                    state.update(bytes.slice(i, chunk));
+                assert(state.digest() == h);
+            }
+        }
+
+        assert(cxx::hash_contents(all.take_front(10)) != cxx::hash_contents(all.take_front(11)));
+        assert(cxx::hash_contents(all.take_front(10)) != cxx::hash_contents(all.take_front(10), 1));
+        auto const h128 = cxx::hash_contents128(all);
+        assert(h128.lo == cxx::hash_contents(all) && h128.hi != h128.lo);
+
+        std::string const s1 = "hello world", s2 = "hello world";
+        std::unordered_map<cxx::array_ref<const char>, int, cxx::content_hash, cxx::content_equal> map;
+        map[cxx::array_ref<const char>(s1)] = 1;
+        assert(map.count(cxx::array_ref<const char>(s2)) == 1);
+        assert(map.count(cxx::array_ref<const char>(s2).drop_back()) == 0);
+    }
+
+    {
+        constexpr int R = 37, C = 53, S = 60;
+        std::vector<float> a(R * S), b(C * R);
+        for (int i = 0; i < R * S; ++i)
+            a[i] = static_cast<float>(i);
+
+        cxx::matrix_ref<float> m(a, R, C, S);
+        assert(m(2, 3) == 2 * S + 3);
+        assert(m.row(1).size() == C && m.row(1)[0] == S);
+        assert(m.block(30, 50, 10, 10).rows() == 7 && m.block(30, 50, 10, 10).cols() == 3);
+
+        cxx::matrix_ref<float> t(b, C, R);
+        cxx::transpose(m, t, 8);
+        for (int r = 0; r < R; ++r)
+            for (int c = 0; c < C; ++c)
+                assert(t(c, r) == m(r, c));
+
+        static_assert(cxx::tile_edge(sizeof(float)) == 64);
+
+        for (auto order : { cxx::tile_order::row_major, cxx::tile_order::column_major, cxx::tile_order::morton }) {
+            std::vector<int> visits(R * C);
+            std::vector<cxx::tile> tiles;
+            cxx::for_each_tile(R, C, 8, 16, order, [&](cxx::tile t) {
+                tiles.push_back(t);
+                for (auto r = t.row; r < t.row + t.rows; ++r)
+                    for (auto c = t.col; c < t.col + t.cols; ++c)
+                        ++visits[r * C + c];
+            });
+            assert(tiles.size() == 5 * 4);
+            assert(std::all_of(visits.begin(), visits.end(), [](int v) { return v == 1; }));
+            if (order == cxx::tile_order::column_major)
+                assert(tiles[1].row == 8 && tiles[1].col == 0);
+            if (order == cxx::tile_order::morton)
+                assert(tiles[2].row == 8 && tiles[2].col == 0 && tiles[3].row == 8 && tiles[3].col == 16);
+        }
+    }
+
+    {
+        std::vector<float> a = { -2, 0.5f, 1, 3, 7 };
+        std::vector<float> b = { 1, 2, 3, 4, 5 };
+        cxx::array_ref<const float> ra = a, rb = b;
+
+        auto scaled = cxx::transform(ra, [](float x) { return x * 2; });
+        auto clamped = cxx::transform(scaled, [](float x) { return x < 0 ? 0 : (x > 10 ? 10 : x); });
+        assert(clamped.size() == 5);
+        assert(clamped[0] == 0 && clamped[4] == 10);
+        assert(clamped.end() - clamped.begin() == 5);
+        assert(cxx::reduce(clamped, 0.0f) == 0 + 1 + 2 + 6 + 10);
+
+        auto positive = cxx::filter(ra, [](float x) { return x > 0; });
+        assert(std::distance(positive.begin(), positive.end()) == 4);
+        assert(*positive.begin() == 0.5f);
+        auto big = cxx::filter(cxx::transform(positive, [](float x) { return x * 10; }), [](float x) { return x >= 10; });
+        assert(cxx::reduce(big, 0.0f) == 110);
+
+        auto z = cxx::zip(ra, rb.take_front(4));
+        assert(z.size() == 4);
+        assert(std::get<1>(z[3]) == 4);
+        auto dot = cxx::reduce(cxx::transform(z, [](auto t) { return std::get<0>(t) * std::get<1>(t); }), 0.0f);
+        assert(dot == -2 + 1 + 3 + 12);
+
+        float out[5] = {};
+        auto rest = cxx::copy(clamped, cxx::array_ref<float>(out));
+        assert(rest.empty());
+        assert(std::equal(clamped.begin(), clamped.end(), out));
+
+        // Iterators returning prvalues are input iterators; returning an
+        // lvalue keeps the traversal of the underlying iterator.
+        static_assert(std::is_same<std::iterator_traits<decltype(clamped.begin())>::iterator_category, std::input_iterator_tag>::value, "");
+        static_assert(std::is_same<std::iterator_traits<decltype(z.begin())>::iterator_category, std::input_iterator_tag>::value, "");
+        static_assert(std::is_same<std::iterator_traits<decltype(big.begin())>::iterator_category, std::input_iterator_tag>::value, "");
+        static_assert(std::is_same<std::iterator_traits<decltype(positive.begin())>::iterator_category, std::forward_iterator_tag>::value, "");
+        auto same = cxx::transform(ra, [](float const& x) -> float const& { return x; });
+        static_assert(std::is_same<std::iterator_traits<decltype(same.begin())>::iterator_category, std::random_access_iterator_tag>::value, "");
+    }
+
+    {
+        for (std::ptrdiff_t n : { 0, 1, 7, 8, 9, 31, 100 }) {
+            std::vector<uint32_t> src(n);
+            for (std::ptrdiff_t i = 0; i < n; ++i)
+                src[i] = static_cast<uint32_t>(i * 3 + 1);
+
+            std::vector<uint32_t> inc(n), exc(n), expected(n);
+            std::partial_sum(src.begin(), src.end(), expected.begin());
+            for (auto& x : expected)
+                x += 5;
+
+            cxx::inclusive_scan<uint32_t>(src, inc, 5);
+            cxx::exclusive_scan<uint32_t>(src, exc, 5);
+            assert(inc == expected);
+            for (std::ptrdiff_t i = 0; i < n; ++i)
+                assert(exc[i] == (i == 0 ? 5 : expected[i - 1]));
+
+            cxx::inclusive_scan<uint32_t>(src, src);
+            for (std::ptrdiff_t i = 0; i < n; ++i)
+                assert(src[i] + 5 == expected[i]);
+        }
+
+        std::vector<float> f(19, 0.5f), fs(19);
+        cxx::exclusive_scan<float>(f, fs);
+        for (int i = 0; i < 19; ++i)
+            assert(fs[i] == 0.5f * i);
+
+        std::vector<int64_t> big(300000), p1(big.size()), p2(big.size());
+        for (std::size_t i = 0; i < big.size(); ++i)
+            big[i] = static_cast<int64_t>(i % 7) - 3;
+        cxx::exclusive_scan<int64_t>(big, p1, 10);
+        cxx::parallel_exclusive_scan<int64_t>(big, p2, 10, 4);
+        assert(p1 == p2);
+        cxx::parallel_inclusive_scan<int64_t>(big, p2, 10, 4);
+        assert(p2.back() == p1.back() + big.back());
+    }
+
+    {
+        std::vector<int32_t> src(203);
+        for (std::size_t i = 0; i < src.size(); ++i)
+            src[i] = static_cast<int32_t>((i * 7919) % 101) - 50;
+
+        auto pred = [](int32_t x) { return x >= 0; };
+
+        std::vector<int32_t> expected;
+        std::vector<uint32_t> expected_idx;
+        for (std::size_t i = 0; i < src.size(); ++i) {
+            if (pred(src[i])) {
+                expected.push_back(src[i]);
+                expected_idx.push_back(static_cast<uint32_t>(i));
+            }
+        }
+
+        std::vector<int32_t> dst(src.size());
+        auto const n = cxx::compact<int32_t>(src, dst, pred);
+        assert(n == static_cast<std::ptrdiff_t>(expected.size()));
+        assert(std::equal(expected.begin(), expected.end(), dst.begin()));
+
+        std::vector<uint32_t> idx(src.size());
+        auto const ni = cxx::compact_indices(cxx::array_ref<int32_t const>(src), idx, pred);
+        assert(ni == n);
+        assert(std::equal(expected_idx.begin(), expected_idx.end(), idx.begin()));
+
+        std::vector<double> d = { 1.5, -1, 2.5, -2, 3.5 };
+        std::vector<double> dd(d.size());
+        assert(cxx::compact<double>(d, dd, [](double x) { return x > 0; }) == 3);
+        assert(dd[0] == 1.5 && dd[1] == 2.5 && dd[2] == 3.5);
+
+        assert(cxx::compact<int32_t>(src, dst, [](int32_t) { return false; }) == 0);
+        assert(cxx::compact<int32_t>(src, dst, [](int32_t) { return true; }) == 203);
+        assert(dst == src);
+    }
+
+    {
+        std::vector<uint8_t> bytes(1000003);
+        for (std::size_t i = 0; i < bytes.size(); ++i)
+            bytes[i] = static_cast<uint8_t>(i % 5 == 0 ? (i * 31) >> 3 : 7);
+
+        std::vector<uint32_t> expected(256);
+        for (auto b : bytes)
+            ++expected[b];
+
+        std::vector<uint32_t> h(256);
+        cxx::histogram(bytes, h);
+        assert(h == expected);
+
+        std::vector<uint32_t> hp(256);
+        cxx::parallel_histogram(bytes, hp, 3);
+        assert(hp == expected);
+
+        std::vector<uint16_t> words(5000);
+        for (std::size_t i = 0; i < words.size(); ++i)
+            words[i] = static_cast<uint16_t>(i * 977);
+        std::vector<uint32_t> h16(65536);
+        cxx::histogram(words, h16);
+        cxx::histogram(words, h16);
+        assert(h16[977] == 2 && h16[0] == 2 && std::accumulate(h16.begin(), h16.end(), 0u) == 10000);
+
+        // With scratch memory, both for small inputs and for inputs large
+        // enough to use sub-histograms.
+        cxx::histogram_scratch scratch;
+        std::vector<uint16_t> many(300000);
+        for (std::size_t i = 0; i < many.size(); ++i)
+            many[i] = static_cast<uint16_t>(i % 3 == 0 ? 42 : i * 7);
+        for (std::size_t n : { std::size_t{100}, many.size() }) {
+            cxx::array_ref<uint16_t const> w = cxx::array_ref<uint16_t const>(many).take_front(static_cast<std::ptrdiff_t>(n));
+            std::vector<uint32_t> hs(65536), hd(65536), hm(65536);
+            cxx::histogram(w, hs, scratch);
+            cxx::histogram(w, hs, scratch);
+            for (uint16_t x : w)
+                hd[x] += 2;
+            assert(hs == hd);
+            cxx::histogram(w, hm, [](uint16_t x) { return x; }, scratch);
+            assert(hm[42] == hd[42] / 2);
+        }
+
+        std::vector<uint32_t> h4(4), hp4(4);
+        auto top2 = [](uint8_t b) { return b >> 6; };
+        cxx::histogram(cxx::array_ref<uint8_t const>(bytes), h4, top2);
+        cxx::parallel_histogram(cxx::array_ref<uint8_t const>(bytes), hp4, top2, 2);
+        assert(h4 == hp4);
+        assert(h4[0] == std::accumulate(expected.begin(), expected.begin() + 64, 0u));
+    }
+
+    {
+        std::vector<int16_t> a = { 1, -2, 3, -4, 5 };
+        std::vector<double> b = { 0.5, 1.5, 2.5 };
+
+        cxx::untyped_array_ref ua = cxx::array_ref<int16_t>(a);
+        assert(ua.tag() == cxx::type_tag::i16);
+        assert(ua.size() == 5 && ua.element_size() == 2 && ua.size_in_bytes() == 10);
+        assert(ua.drop_front(1).take_front(3).as<int16_t>()[2] == -4);
+        assert(ua.slice(3).size() == 2 && ua.take_back(2).as<int16_t>()[0] == -4);
+
+        auto sum = [](auto arr) {
+            double s = 0;
+            for (auto x : arr)
+                s += x;
+            return s;
+        };
+        assert(cxx::visit(sum, ua) == 3);
+        assert(cxx::visit(sum, ua.drop_back(2)) == 2);
+
+        cxx::mutable_untyped_array_ref mb = cxx::array_ref<double>(b);
+        cxx::visit([](auto arr) { for (auto& x : arr) x *= 2; }, mb);
+        assert(b[2] == 5);
+        cxx::untyped_array_ref cb = mb;
+        assert(cxx::visit(sum, cb) == 9);
+        assert(cb.bytes().size() == 24);
+
+        static_assert(!std::is_convertible<cxx::array_ref<int const>, cxx::mutable_untyped_array_ref>::value, "");
+        static_assert(!std::is_convertible<cxx::untyped_array_ref, cxx::mutable_untyped_array_ref>::value, "");
+        static_assert(!std::is_convertible<cxx::array_ref<char>, cxx::untyped_array_ref>::value, "");
+    }
+
+    {
+        uint64_t wa[3] = {}, wb[3] = {}, wc[3] = {};
+        cxx::bit_array_ref<uint64_t> a(wa, 150), b(wb, 150), c(wc, 150);
+        assert(a.words().size() == 3);
+
+        for (int i = 0; i < 150; i += 3)
+            a.set(i);
+        for (int i = 0; i < 150; i += 5)
+            b.set(i);
+        assert(a.count() == 50 && b.count() == 30);
+        assert(a.test(66) && !a.test(67) && a[147]);
+        assert(a.rank(64) == 22 && a.rank(150) == 50);
+
+        cxx::bit_and(c, a, b);
+        assert(c.count() == 10);
+        assert(c.find_first() == 0 && c.find_next(1) == 15 && c.find_next(136) == 150);
+        cxx::bit_or(c, a, b);
+        assert(c.count() == 70);
+        cxx::bit_xor(c, a, b);
+        assert(c.count() == 60);
+        cxx::bit_andnot(c, a, b);
+        assert(c.count() == 40);
+
+        // Bits past size() are ignored.
+        wc[2] |= ~uint64_t{0} << 30;
+        assert(c.count() == 40);
+        assert(c.find_next(148) == 150);
+
+        uint32_t idx[150];
+        auto const n = cxx::to_indices(c, idx);
+        assert(n == 40 && idx[0] == 3 && idx[1] == 6 && idx[2] == 9 && idx[3] == 12 && idx[4] == 18);
+
+        uint64_t wd[3];
+        cxx::bit_array_ref<uint64_t> d(wd, 150);
+        cxx::from_indices(cxx::array_ref<uint32_t const>(idx, n), d);
+        cxx::bit_xor(d, d, c);
+        assert(d.count() == 0 && d.find_first() == d.size());
+
+        std::vector<uint64_t> many(37);
+        cxx::bit_array_ref<uint64_t> e(many);
+        e.fill(true);
+        e.reset(100);
+        assert(e.size() == 37 * 64 && e.count() == e.size() - 1);
+        cxx::bit_and(e, e, e);
+        assert(e.count() == e.size() - 1 && !e[100]);
+    }
+
+    {
+        std::string text;
+        for (int i = 0; i < 40; ++i)
+            text += "GET /index.html 200 ";
+        text += "POST /api/v1 500\xC3\xA9 done";
+        cxx::array_ref<char const> t(text.data(), static_cast<std::ptrdiff_t>(text.size()));
+
+        auto ref = [&](std::string const& needle) {
+            auto const pos = text.find(needle);
+            return pos == std::string::npos ? t.size() : static_cast<std::ptrdiff_t>(pos);
+        };
+        auto pos = [&](cxx::array_ref<char const> r) { return r.data() - t.data(); };
+        auto str = [](char const* s) { return cxx::array_ref<char const>(s, static_cast<std::ptrdiff_t>(std::strlen(s))); };
+
+        assert(pos(cxx::find_byte(t, 'P')) == ref("P"));
+        assert(cxx::find_byte(t, 'Z').empty() && pos(cxx::find_byte(t, 'Z')) == t.size());
+        assert(pos(cxx::find_byte(t, '\xA9')) == ref("\xA9"));
+
+        assert(pos(cxx::find_any_of(t, str("5Z"))) == ref("5"));
+        assert(pos(cxx::find_any_of(t, str("\xC3q"))) == ref("\xC3"));
+        assert(cxx::find_any_of(t, str("qjk")).empty());
+
+        for (char const* needle : { "POST", "500", "00 P", "v1 500\xC3\xA9 done", "e", "html 200 GET", "doneX", "" }) {
+            auto const r = cxx::search(t, str(needle));
+            assert(pos(r) == ref(needle));
+            assert(r.size() == (pos(r) == t.size() ? 0 : static_cast<std::ptrdiff_t>(std::strlen(needle))));
+        }
+
+        std::byte raw[70] = {};
+        raw[66] = std::byte{7};
+        raw[67] = std::byte{9};
+        cxx::array_ref<std::byte const> br(raw);
+        std::byte const pat[2] = { std::byte{7}, std::byte{9} };
+        assert(cxx::find_byte(br, std::byte{9}).size() == 3);
+        assert(cxx::search(br, cxx::array_ref<std::byte const>(pat)).data() == raw + 66);
+    }
+
+    {
+        std::string text;
+        for (int i = 0; i < 30; ++i)
+            text += std::string(static_cast<std::size_t>(i), 'a') + (i % 3 == 0 ? "\r\n" : "\n");
+        text += "last\r";
+        cxx::array_ref<char const> t(text.data(), static_cast<std::ptrdiff_t>(text.size()));
+
+        std::vector<std::string> got;
+        for (auto line : cxx::lines(t))
+            got.emplace_back(line.begin(), line.end());
+        assert(got.size() == 31);
+        for (int i = 0; i < 30; ++i)
+            assert(got[i] == std::string(static_cast<std::size_t>(i), 'a'));
+        assert(got[30] == "last\r");
+
+        auto const n = cxx::line_offsets(t, {});
+        assert(n == 31);
+        std::vector<uint32_t> offsets(n);
+        assert(cxx::line_offsets(t, offsets) == n);
+        std::ptrdiff_t k = 0;
+        for (auto it = cxx::lines(t).begin(); it != cxx::lines(t).end(); ++it, ++k)
+            assert(it.rest().data() == t.data() + offsets[k]);
+
+        auto count = [](char const* s) {
+            auto const r = cxx::array_ref<char const>(s, static_cast<std::ptrdiff_t>(std::strlen(s)));
+            auto const rng = cxx::lines(r);
+            assert(std::distance(rng.begin(), rng.end()) == cxx::line_offsets(r, {}));
+            return cxx::line_offsets(r, {});
+        };
+        assert(count("") == 0);
+        assert(count("\n") == 1);
+        assert(count("\n\n") == 2);
+        assert(count("a\nb") == 2);
+        assert(count("a\nb\n") == 2);
+        assert((*cxx::lines(cxx::array_ref<char const>("\r\n", 2)).begin()).empty());
+    }
+
+    {
+        std::string csv = "id,name,score\r\n";
+        for (int i = 0; i < 20; ++i) {
+            csv += std::to_string(i - 5) + ",";
+            csv += (i % 4 == 0 ? "\"Doe, J\nr.\"" : "plain") + std::string(",");
+            csv += std::to_string(i) + ".25\n";
+        }
+        csv += "99,\"\"\"quoted\"\"\",-1e3";
+        cxx::array_ref<char const> text(csv.data(), static_cast<std::ptrdiff_t>(csv.size()));
+
+        auto const counts = cxx::csv_tokenize(text, {}, {});
+        assert(counts.rows == 22 && counts.fields == 66);
+
+        std::vector<uint32_t> field_ends(counts.fields), row_ends(counts.rows);
+        auto const again = cxx::csv_tokenize(text, field_ends, row_ends);
+        assert(again.rows == counts.rows && again.fields == counts.fields);
+
+        cxx::csv_table table(text, field_ends, row_ends);
+        auto str = [](cxx::array_ref<char const> f) { return std::string(f.begin(), f.end()); };
+        assert(table.rows() == 22);
+        assert(str(table.field(0, 0)) == "id" && str(table.field(0, 2)) == "score");
+        assert(str(table.field(1, 1)) == "Doe, J\nr.");
+        assert(str(table.field(2, 1)) == "plain");
+        assert(str(table.field(21, 1)) == "\"\"quoted\"\"");
+        assert(table.fields(5) == 3 && table.field(5, 3).empty());
+
+        std::vector<int64_t> ids(21);
+        std::vector<double> scores(21);
+        assert(cxx::parse_column(table, 0, 1, ids) == 21);
+        assert(ids[0] == -5 && ids[19] == 14 && ids[20] == 99);
+        assert(cxx::parse_column(table, 2, 1, scores) == 21);
+        assert(scores[3] == 3.25 && scores[20] == -1000);
+        assert(cxx::parse_column(table, 1, 1, ids) == 0);
+
+        auto count = [](char const* s) {
+            return cxx::csv_tokenize(cxx::array_ref<char const>(s, static_cast<std::ptrdiff_t>(std::strlen(s))), {}, {});
+        };
+        assert(count("").rows == 0);
+        assert(count("a").rows == 1 && count("a").fields == 1);
+        assert(count("a,\n").fields == 2 && count("a,\n").rows == 1);
+        assert(count("\n\n").rows == 2);
+        assert(count("\"a\nb\"\n").rows == 1);
+    }
+
+    {
+        static constexpr auto table = [] {
+            std::array<int, 24> a = {};
+            for (int i = 0; i < 24; ++i)
+                a[i] = (i * 17) % 24 - 5;
+            cxx::sort(cxx::array_ref<int>(a));
+            return a;
+        }();
+        constexpr cxx::array_ref<int const> t = table;
+        static_assert(cxx::is_sorted(t), "");
+        static_assert(t[0] == -5 && t[23] == 18, "");
+        static_assert(cxx::binary_search(t, 7), "");
+        static_assert(!cxx::binary_search(t, 19), "");
+        static_assert(cxx::lower_bound(t, 7).size() == 12, "");
+        static_assert(cxx::upper_bound(t, 7).size() == 11, "");
+        static_assert(cxx::lower_bound(t, 100).empty(), "");
+        static_assert(cxx::find(t, 3).size() == 16, "");
+        static_assert(cxx::find(t, 99).empty(), "");
+        static_assert(cxx::find_if(t, [](int x) { return x > 10; })[0] == 11, "");
+        static_assert(cxx::reduce(t, 0) == 156, "");
+        static_assert(cxx::reduce(t, -100, [](int x, int y) { return x < y ? y : x; }) == 18, "");
+
+        constexpr auto small = [] {
+            std::array<char, 5> s = { 'd', 'a', 'e', 'c', 'b' };
+            cxx::sort(cxx::array_ref<char>(s), std::greater<>{});
+            return s;
+        }();
+        static_assert(small[0] == 'e' && small[4] == 'a', "");
+
+        std::vector<std::string> words = { "pear", "apple", "fig", "banana" };
+        cxx::sort(cxx::array_ref<std::string>(words));
+        assert(words[0] == "apple" && words[3] == "pear");
+        assert(cxx::binary_search(cxx::array_ref<std::string const>(words), std::string("fig")));
+    }
+
+    {
+        static constexpr std::string_view names[] = {
+            "add", "sub", "mul", "div", "mod", "and", "or", "xor", "not", "shl", "shr",
+            "load", "store", "jmp", "jz", "jnz", "call", "ret", "push", "pop", "nop",
+        };
+        static constexpr int opcodes[] = {
+            0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20,
+        };
+        static constexpr auto ops = cxx::make_perfect_hash_map(names, opcodes);
+        static_assert(ops.size() == 21, "");
+        static_assert(*ops.find("jnz") == 15, "");
+        static_assert(ops.find("halt") == nullptr, "");
+        static_assert(!ops.contains("ad"), "");
+        for (int i = 0; i < 21; ++i)
+            assert(ops.find(names[i]) != nullptr && *ops.find(names[i]) == i);
+        assert(!ops.contains(std::string("addd")));
+
+        static constexpr auto squares = [] {
+            std::array<uint32_t, 200> k = {};
+            for (uint32_t i = 0; i < 200; ++i)
+                k[i] = i * 7919u;
+            return k;
+        }();
+        static constexpr cxx::perfect_hash_map<uint32_t, uint32_t, 200> m(squares, squares);
+        static_assert(*m.find(199 * 7919u) == 199 * 7919u, "");
+        for (uint32_t i = 0; i < 200 * 7919u; ++i)
+            assert((m.find(i) != nullptr) == (i % 7919u == 0));
+
+        // Duplicate keys are rejected, also with NDEBUG.
+        static constexpr int dup_keys[] = { 1, 2, 3, 2 };
+        static constexpr int dup_values[] = { 10, 20, 30, 40 };
+        bool rejected = false;
+        try {
+            cxx::make_perfect_hash_map(dup_keys, dup_values);
+        } catch (std::invalid_argument const&) {
+            rejected = true;
+        }
+        assert(rejected);
+    }
+
+    {
+#if __cpp_lib_string_view >= 201606
+        static constexpr std::string_view sv = "hello world";
+        constexpr cxx::array_ref<char const> r = sv;
+        static_assert(r.size() == 11 && r[4] == 'o', "");
+        static_assert(cxx::to_string_view(r.drop_front(6)) == "world", "");
+        static_assert(noexcept(cxx::array_ref<char const>(sv)), "");
+        static_assert(!std::is_convertible<std::string_view, cxx::array_ref<char>>::value, "");
+        static_assert(std::is_same<decltype(cxx::to_string_view(cxx::array_ref<char16_t>())), std::u16string_view>::value, "");
+#endif
+#if __cpp_lib_span >= 202002
+        int a[4] = { 1, 2, 3, 4 };
+        std::span<int> s = a;
+        cxx::array_ref<int> ra = s;
+        cxx::array_ref<int const> rc = std::span<int, 4>(a);
+        assert(ra.data() == a && ra.size() == 4 && rc.size() == 4);
+
+        std::span<int> back = cxx::to_span(ra.drop_front(1));
+        assert(back.data() == a + 1 && back.size() == 3);
+        std::span<int const, 2> fixed = cxx::to_span<2>(rc.take_back(2));
+        static_assert(decltype(fixed)::extent == 2);
+        assert(fixed[1] == 4);
+
+        static constexpr int ca[3] = { 7, 8, 9 };
+        static_assert(cxx::to_span(cxx::array_ref<int const>(std::span<int const>(ca))).size() == 3);
+        static_assert(noexcept(cxx::array_ref<int>(s)) && noexcept(cxx::to_span(ra)));
+        static_assert(!std::is_convertible<std::span<int const>, cxx::array_ref<int>>::value);
+#endif
+    }
+
+    {
+        std::ptrdiff_t const n = 3 * 1024 * 1024 / 8 + 5;
+        for (auto kind : { cxx::page_kind::normal, cxx::page_kind::transparent, cxx::page_kind::huge_2m, cxx::page_kind::huge_1g }) {
+            cxx::huge_page_options options;
+            options.pages = kind;
+            options.policy = cxx::numa_policy::interleave;
+
+            cxx::huge_array<uint64_t> a(n, options);
+            assert(a.error() == 0 && a.numa_error() == 0);
+            assert(a.size() == n);
+            if (a.pages() != cxx::page_kind::normal)
+                assert(reinterpret_cast<std::uintptr_t>(a.data()) % (2 * 1024 * 1024) == 0);
+
+            cxx::array_ref<uint64_t> r = a;
+            assert(r[0] == 0 && r[n - 1] == 0);
+            r[n - 1] = 42;
+
+            cxx::huge_array<uint64_t> b = std::move(a);
+            assert(a.empty() && b.get()[n - 1] == 42);
+        }
+
+        assert(cxx::numa_node_count() >= 1);
+        cxx::huge_array<char> none(0);
+        assert(none.empty() && none.error() == 0);
+    }
+
+    {
+        cxx::huge_array<double> buf(100000, { cxx::page_kind::transparent });
+        cxx::array_ref<double> a = buf;
+
+        cxx::static_partitioner part(4);
+        assert(part.threads() == 4);
+        std::ptrdiff_t total = 0;
+        for (int t = 0; t < 4; ++t) {
+            auto const p = part.part(a, t);
+            total += p.size();
+            if (t > 0)
+                assert(reinterpret_cast<std::uintptr_t>(p.data()) % 4096 == 0);
+            if (t > 0)
+                assert(p.data() == part.part(a, t - 1).data() + part.part(a, t - 1).size());
+        }
+        assert(total == a.size());
+
+        cxx::parallel_first_touch(a, part, 1.5);
+        assert(std::all_of(a.begin(), a.end(), [](double x) { return x == 1.5; }));
+
+        std::vector<double> sums(4);
+        cxx::parallel_for(a, part, [&](cxx::array_ref<double> p, int t) {
+            sums[t] = std::accumulate(p.begin(), p.end(), 0.0);
+        });
+        assert(std::accumulate(sums.begin(), sums.end(), 0.0) == 1.5 * 100000);
+
+        std::vector<int> small(10);
+        cxx::parallel_first_touch(cxx::array_ref<int>(small), cxx::static_partitioner(3, false), 7);
+        assert(small[0] == 7 && small[9] == 7);
+
+#if defined(__linux__)
+        // Threads are pinned to CPUs from the affinity mask only.
+        auto const allowed = cxx::detail::allowed_cpus();
+        assert(!allowed.empty());
+        std::vector<int> ran_on(4, -1);
+        cxx::parallel_for(a, part, [&](cxx::array_ref<double>, int t) {
+            ran_on[t] = sched_getcpu();
+        });
+        for (int cpu : ran_on)
+            assert(std::find(allowed.begin(), allowed.end(), cpu) != allowed.end());
+#endif
+    }
+
+#if __cpp_lib_atomic_ref >= 201806
+    {
+        std::vector<uint64_t> counts(16);
+        cxx::atomic_array_ref<uint64_t> a(counts);
+        assert(a.size() == 16);
+
+        a.fill(1);
+        assert(a.load(3) == 1);
+        assert(a.fetch_add(3, 2) == 1);
+        assert(a[3].load() == 3);
+        assert(a.exchange(4, 9) == 1);
+        uint64_t expected = 0;
+        assert(!a.compare_exchange_strong(4, expected, 5) && expected == 9);
+        assert(a.compare_exchange_strong(4, expected, 5) && counts[4] == 5);
+        assert(a.fetch_or(0, 6) == 1 && counts[0] == 7);
+
+        uint64_t const zeros[4] = {};
+        a.store(zeros);
+        std::vector<uint32_t> bins(40000);
+        for (size_t i = 0; i < bins.size(); ++i)
+            bins[i] = i % 4;
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t) {
+            threads.emplace_back([&, t] {
+                auto const part = cxx::array_ref<uint32_t const>(bins).slice(t * 10000, 10000);
+                a.take_front(4).fetch_add(part, 1);
+            });
+        }
+        for (auto& th : threads)
+            th.join();
+
+        uint64_t out[4] = {};
+        a.load(out);
+        assert(out[0] == 10000 && out[1] == 10000 && out[2] == 10000 && out[3] == 10000);
+        assert(a.drop_front(4).load(1) == 1);
+    }
+#endif
+}
@@ -0,0 +1,256 @@
+// Distributed under the MIT license. See the end of the file for details.
+
+#pragma once
+
+#include "ArrayRef.h"
+
+#include <cstdint>
+#include <type_traits>
+
+namespace cxx {
+
+//------------------------------------------------------------------------------
+//
+//------------------------------------------------------------------------------
+
+// A row-major matrix view of an array. Row r starts at data[r * stride].
+template <typename T>
+class matrix_ref
+{
+public:
+    using element_type    = T;
+    using value_type      = std::remove_cv_t<T>;
+    using reference       = std::add_lvalue_reference_t<T>;
+    using pointer         = std::add_pointer_t<T>;
+    using difference_type = std::ptrdiff_t;
+
+private:
+    pointer data_ = nullptr;
+    difference_type rows_ = 0;
+    difference_type cols_ = 0;
+    difference_type stride_ = 0;
+
+    static constexpr difference_type Min(difference_type x, difference_type y) {
+        return y < x ? y : x;
+    }
+
+    constexpr matrix_ref(pointer data, difference_type rows, difference_type cols, difference_type stride) noexcept
+        : data_(data)
+        , rows_(rows)
+        , cols_(cols)
+        , stride_(stride)
+    {
+    }
+
+public:
+    constexpr matrix_ref() noexcept = default;
+    constexpr matrix_ref(matrix_ref const&) noexcept = default;
+    constexpr matrix_ref& operator=(matrix_ref const&) noexcept = default;
+
+    constexpr matrix_ref(array_ref<T> data, difference_type rows, difference_type cols, difference_type stride) noexcept
+        : data_(data.data())
+        , rows_(rows)
+        , cols_(cols)
+        , stride_(stride)
+    {
+        assert(rows_ >= 0 && cols_ >= 0);
+        assert(stride_ >= cols_);
+        assert(rows_ == 0 || (rows_ - 1) * stride_ + cols_ <= data.size());
+    }
+
+    constexpr matrix_ref(array_ref<T> data, difference_type rows, difference_type cols) noexcept
+        : matrix_ref(data, rows, cols, cols)
+    {
+    }
+
+    template <
+        typename U,
+        typename = std::enable_if_t< is_array_convertible<U, element_type>::value >
+    >
+    constexpr matrix_ref(matrix_ref<U> const& rhs) noexcept
+        : data_(rhs.data())
+        , rows_(rhs.rows())
+        , cols_(rhs.cols())
+        , stride_(rhs.stride())
+    {
+    }
+
+    constexpr pointer data() const noexcept {
+        return data_;
+    }
+
+    constexpr difference_type rows() const noexcept {
+        return rows_;
+    }
+
+    constexpr difference_type cols() const noexcept {
+        return cols_;
+    }
+
+    constexpr difference_type stride() const noexcept {
+        return stride_;
+    }
+
+    constexpr bool empty() const noexcept {
+        return rows_ == 0 || cols_ == 0;
+    }
+
+    constexpr reference operator()(difference_type r, difference_type c) const noexcept {
+        assert(r >= 0 && r < rows_);
+        assert(c >= 0 && c < cols_);
+        return data_[r * stride_ + c];
+    }
+
+    constexpr array_ref<T> row(difference_type r) const noexcept {
+        assert(r >= 0 && r < rows_);
+        return { data_ + r * stride_, cols_ };
+    }
+
+    // Returns the sub-matrix [r, r + nr) x [c, c + nc), clipped to this
+    // matrix.
+    constexpr matrix_ref block(difference_type r, difference_type c, difference_type nr, difference_type nc) const noexcept {
+        assert(r >= 0 && r <= rows_);
+        assert(c >= 0 && c <= cols_);
+        return { data_ + r * stride_ + c, Min(nr, rows_ - r), Min(nc, cols_ - c), stride_ };
+    }
+};
+
+//------------------------------------------------------------------------------
+// Tiling
+//------------------------------------------------------------------------------
+
+enum class tile_order {
+    row_major,
+    column_major,
+    morton,
+};
+
+struct tile
+{
+    std::ptrdiff_t row;
+    std::ptrdiff_t col;
+    std::ptrdiff_t rows;
+    std::ptrdiff_t cols;
+};
+
+// Returns the largest power-of-two edge length of a square tile of elements
+// of the given size, such that two tiles fit into cache_bytes.
+constexpr std::ptrdiff_t tile_edge(std::ptrdiff_t element_size, std::ptrdiff_t cache_bytes = 32 * 1024) noexcept
+{
+    std::ptrdiff_t edge = 1;
+    while (2 * (2 * edge) * (2 * edge) * element_size <= cache_bytes)
+        edge *= 2;
+    return edge;
+}
+
+namespace detail {
+
+// Visits the cells of the grid [0, nr) x [0, nc) inside the size x size
+// square at (r, c) in Z-order, skipping the parts outside the grid.
+template <typename F>
+void visit_morton(std::ptrdiff_t r, std::ptrdiff_t c, std::ptrdiff_t size, std::ptrdiff_t nr, std::ptrdiff_t nc, F& f)
+{
+    if (r >= nr || c >= nc)
+        return;
+
+    if (size == 1) {
+        f(r, c);
+        return;
+    }
+
+    std::ptrdiff_t const h = size / 2;
+    visit_morton(r,     c,     h, nr, nc, f);
+    visit_morton(r,     c + h, h, nr, nc, f);
+    visit_morton(r + h, c,     h, nr, nc, f);
+    visit_morton(r + h, c + h, h, nr, nc, f);
+}
+
+} // namespace detail
+
+// Splits a rows x cols matrix into tiles of at most tile_rows x tile_cols
+// and calls f(tile) for each of them in the given order.
+template <typename F>
+void for_each_tile(std::ptrdiff_t rows, std::ptrdiff_t cols, std::ptrdiff_t tile_rows, std::ptrdiff_t tile_cols, tile_order order, F f)
+{
+    assert(tile_rows > 0 && tile_cols > 0);
+
+    std::ptrdiff_t const nr = (rows + tile_rows - 1) / tile_rows;
+    std::ptrdiff_t const nc = (cols + tile_cols - 1) / tile_cols;
+
+    auto visit = [&](std::ptrdiff_t i, std::ptrdiff_t j) {
+        std::ptrdiff_t const r = i * tile_rows;
+        std::ptrdiff_t const c = j * tile_cols;
+        f(tile { r, c, (rows - r < tile_rows ? rows - r : tile_rows), (cols - c < tile_cols ? cols - c : tile_cols) });
+    };
+
+    switch (order) {
+    case tile_order::row_major:
+        for (std::ptrdiff_t i = 0; i < nr; ++i)
+            for (std::ptrdiff_t j = 0; j < nc; ++j)
+                visit(i, j);
+        break;
+    case tile_order::column_major:
+        for (std::ptrdiff_t j = 0; j < nc; ++j)
+            for (std::ptrdiff_t i = 0; i < nr; ++i)
+                visit(i, j);
+        break;
+    case tile_order::morton: {
+        std::ptrdiff_t size = 1;
+        while (size < nr || size < nc)
+            size *= 2;
+        detail::visit_morton(0, 0, size, nr, nc, visit);
+        break;
+    }
+    }
+}
+
+// Calls f(block) for each tile of m.
+template <typename T, typename F>
+void for_each_tile(matrix_ref<T> m, std::ptrdiff_t tile_rows, std::ptrdiff_t tile_cols, tile_order order, F f)
+{
+    for_each_tile(m.rows(), m.cols(), tile_rows, tile_cols, order, [&](tile t) {
+        f(m.block(t.row, t.col, t.rows, t.cols));
+    });
+}
+
+// Sets dst(c, r) = src(r, c), one tile_edge x tile_edge block at a time so
+// that both the rows read from src and the columns written to dst stay in
+// cache. The matrices must not overlap.
+template <typename T>
+void transpose(matrix_ref<std::add_const_t<T>> src, matrix_ref<T> dst, std::ptrdiff_t edge = tile_edge(sizeof(T)))
+{
+    assert(dst.rows() == src.cols());
+    assert(dst.cols() == src.rows());
+
+    for_each_tile(src.rows(), src.cols(), edge, edge, tile_order::row_major, [&](tile t) {
+        T const* const s = src.data();
+        T* const d = dst.data();
+        for (std::ptrdiff_t r = t.row; r < t.row + t.rows; ++r) {
+            for (std::ptrdiff_t c = t.col; c < t.col + t.cols; ++c)
+                d[c * dst.stride() + r] = s[r * src.stride() + c];
+        }
+    });
+}
+
+} // namespace cxx
+
+//------------------------------------------------------------------------------
+// Copyright 2017 A. Bolz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
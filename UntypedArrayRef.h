@@ -0,0 +1,262 @@
+// Distributed under the MIT license. See the end of the file for details.
+
+#pragma once
+
+#include "ArrayRef.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace cxx {
+
+// The element types an untyped_array_ref can hold.
+enum class type_tag : uint8_t {
+    i8,
+    u8,
+    i16,
+    u16,
+    i32,
+    u32,
+    i64,
+    u64,
+    f32,
+    f64,
+};
+
+template <typename T> struct type_tag_of;
+template <> struct type_tag_of<int8_t>   : std::integral_constant<type_tag, type_tag::i8> {};
+template <> struct type_tag_of<uint8_t>  : std::integral_constant<type_tag, type_tag::u8> {};
+template <> struct type_tag_of<int16_t>  : std::integral_constant<type_tag, type_tag::i16> {};
+template <> struct type_tag_of<uint16_t> : std::integral_constant<type_tag, type_tag::u16> {};
+template <> struct type_tag_of<int32_t>  : std::integral_constant<type_tag, type_tag::i32> {};
+template <> struct type_tag_of<uint32_t> : std::integral_constant<type_tag, type_tag::u32> {};
+template <> struct type_tag_of<int64_t>  : std::integral_constant<type_tag, type_tag::i64> {};
+template <> struct type_tag_of<uint64_t> : std::integral_constant<type_tag, type_tag::u64> {};
+template <> struct type_tag_of<float>    : std::integral_constant<type_tag, type_tag::f32> {};
+template <> struct type_tag_of<double>   : std::integral_constant<type_tag, type_tag::f64> {};
+
+// Returns the size in bytes of an element of the given type.
+constexpr std::ptrdiff_t type_tag_size(type_tag tag) noexcept
+{
+    switch (tag) {
+    case type_tag::i8:
+    case type_tag::u8:
+        return 1;
+    case type_tag::i16:
+    case type_tag::u16:
+        return 2;
+    case type_tag::i32:
+    case type_tag::u32:
+    case type_tag::f32:
+        return 4;
+    case type_tag::i64:
+    case type_tag::u64:
+    case type_tag::f64:
+        return 8;
+    }
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+//
+//------------------------------------------------------------------------------
+
+// An array_ref whose element type is only known at run time.
+//
+// ByteT is std::byte const for read-only (untyped_array_ref) and std::byte
+// for writable (mutable_untyped_array_ref) arrays. Use visit to get back a
+// typed array_ref.
+template <typename ByteT>
+class basic_untyped_array_ref
+{
+    static_assert(std::is_same<std::remove_const_t<ByteT>, std::byte>::value, "invalid template argument");
+
+    template <typename T>
+    using typed_element_t = std::conditional_t<std::is_const<ByteT>::value, T const, T>;
+
+public:
+    using pointer         = ByteT*;
+    using difference_type = std::ptrdiff_t;
+
+private:
+    pointer data_ = nullptr;
+    difference_type size_ = 0;
+    difference_type element_size_ = 1;
+    type_tag tag_ = type_tag::u8;
+
+    static constexpr difference_type Min(difference_type x, difference_type y) {
+        return y < x ? y : x;
+    }
+
+public:
+    constexpr basic_untyped_array_ref() noexcept = default;
+    constexpr basic_untyped_array_ref(basic_untyped_array_ref const&) noexcept = default;
+    constexpr basic_untyped_array_ref& operator=(basic_untyped_array_ref const&) noexcept = default;
+
+    // Constructs an untyped array of n elements of the given type at data.
+    constexpr basic_untyped_array_ref(pointer data, difference_type n, type_tag tag) noexcept
+        : data_(data)
+        , size_(n)
+        , element_size_(type_tag_size(tag))
+        , tag_(tag)
+    {
+        assert(size_ >= 0);
+        assert(size_ == 0 || data_ != nullptr);
+    }
+
+    template <
+        typename T,
+        typename = std::enable_if_t< is_array_convertible<T, typed_element_t<std::remove_const_t<T>>>::value >,
+        typename = decltype(type_tag_of<std::remove_const_t<T>>::value)
+    >
+    basic_untyped_array_ref(array_ref<T> arr) noexcept
+        : data_(reinterpret_cast<pointer>(arr.data()))
+        , size_(arr.size())
+        , element_size_(static_cast<difference_type>(sizeof(T)))
+        , tag_(type_tag_of<std::remove_const_t<T>>::value)
+    {
+    }
+
+    // Converts a mutable_untyped_array_ref into an untyped_array_ref.
+    template <
+        typename OtherByteT,
+        typename = std::enable_if_t< is_array_convertible<OtherByteT, ByteT>::value >
+    >
+    constexpr basic_untyped_array_ref(basic_untyped_array_ref<OtherByteT> const& rhs) noexcept
+        : data_(rhs.data())
+        , size_(rhs.size())
+        , element_size_(rhs.element_size())
+        , tag_(rhs.tag())
+    {
+    }
+
+    constexpr pointer data() const noexcept {
+        return data_;
+    }
+
+    // Returns the number of elements.
+    constexpr difference_type size() const noexcept {
+        return size_;
+    }
+
+    constexpr difference_type element_size() const noexcept {
+        return element_size_;
+    }
+
+    constexpr difference_type size_in_bytes() const noexcept {
+        return size_ * element_size_;
+    }
+
+    constexpr type_tag tag() const noexcept {
+        return tag_;
+    }
+
+    constexpr bool empty() const noexcept {
+        return size_ == 0;
+    }
+
+    // Returns the underlying bytes.
+    constexpr array_ref<ByteT> bytes() const noexcept {
+        return { data_, size_in_bytes() };
+    }
+
+    // Returns the array as an array_ref<T>. T must match tag().
+    template <typename T>
+    array_ref<typed_element_t<T>> as() const noexcept {
+        assert(tag_ == type_tag_of<T>::value);
+        return { reinterpret_cast<typed_element_t<T>*>(data_), size_ };
+    }
+
+    // Returns [first, first + n)
+    constexpr basic_untyped_array_ref slice(difference_type first, difference_type n) const noexcept {
+        return drop_front(first).take_front(n);
+    }
+
+    // Returns [first, end)
+    constexpr basic_untyped_array_ref slice(difference_type first) const noexcept {
+        return drop_front(first);
+    }
+
+    // Returns the first n elements.
+    constexpr basic_untyped_array_ref take_front(difference_type n = 1) const noexcept {
+        return { data_, Min(n, size_), tag_ };
+    }
+
+    // Returns the last n elements.
+    constexpr basic_untyped_array_ref take_back(difference_type n = 1) const noexcept {
+        n = Min(n, size_);
+        return { data_ + (size_ - n) * element_size_, n, tag_ };
+    }
+
+    // Removes the first n elements.
+    constexpr basic_untyped_array_ref drop_front(difference_type n = 1) const noexcept {
+        n = Min(n, size_);
+        return { data_ + n * element_size_, size_ - n, tag_ };
+    }
+
+    // Removes the last n elements.
+    constexpr basic_untyped_array_ref drop_back(difference_type n = 1) const noexcept {
+        return { data_, size_ - Min(n, size_), tag_ };
+    }
+};
+
+using untyped_array_ref = basic_untyped_array_ref<std::byte const>;
+using mutable_untyped_array_ref = basic_untyped_array_ref<std::byte>;
+
+// Calls f(arr.as<T>()) where T is the element type of arr, and returns the
+// result. f is typically a generic lambda and must return the same type for
+// all element types.
+//
+// The switch is done once per call, so pass whole batches: inside f the
+// elements are accessed through a plain array_ref<T>.
+template <typename F, typename ByteT>
+decltype(auto) visit(F&& f, basic_untyped_array_ref<ByteT> arr)
+{
+    switch (arr.tag()) {
+    case type_tag::i8:
+        return f(arr.template as<int8_t>());
+    case type_tag::u8:
+        return f(arr.template as<uint8_t>());
+    case type_tag::i16:
+        return f(arr.template as<int16_t>());
+    case type_tag::u16:
+        return f(arr.template as<uint16_t>());
+    case type_tag::i32:
+        return f(arr.template as<int32_t>());
+    case type_tag::u32:
+        return f(arr.template as<uint32_t>());
+    case type_tag::i64:
+        return f(arr.template as<int64_t>());
+    case type_tag::u64:
+        return f(arr.template as<uint64_t>());
+    case type_tag::f32:
+        return f(arr.template as<float>());
+    case type_tag::f64:
+        break;
+    }
+    return f(arr.template as<double>());
+}
+
+} // namespace cxx
+
+//------------------------------------------------------------------------------
+// Copyright 2017 A. Bolz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
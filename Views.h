@@ -0,0 +1,602 @@
+// Distributed under the MIT license. See the end of the file for details.
+
+#pragma once
+
+#include "ArrayRef.h"
+
+#include <iterator>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace cxx {
+
+// Lazy views over array_refs. Views are cheap to copy and store their inputs
+// by value, so they compose without allocating.
+//
+// Iterating a view with begin()/end() works as usual, but the algorithms at
+// the end of this file use for_each instead: each view pushes its elements
+// into a callback, so a composed pipeline turns into a single loop over the
+// underlying array_refs which the compiler can vectorize.
+
+struct view_base {};
+
+template <typename V>
+using is_view = std::is_base_of<view_base, V>;
+
+template <typename V>
+struct is_view_source : is_view<V> {};
+
+template <typename T>
+struct is_view_source<array_ref<T>> : std::true_type {};
+
+namespace detail {
+
+template <typename T, typename F>
+void view_for_each(array_ref<T> const& a, F&& f)
+{
+    auto const p = a.data();
+    auto const n = a.size();
+    for (std::ptrdiff_t i = 0; i < n; ++i)
+        f(p[i]);
+}
+
+template <typename V, typename F, typename = std::enable_if_t< is_view<V>::value >>
+void view_for_each(V const& v, F&& f)
+{
+    v.for_each(std::forward<F>(f));
+}
+
+template <typename V>
+using view_iterator_t = decltype(std::declval<V const&>().begin());
+
+// Iterators whose operator* returns a prvalue are only input iterators (in
+// the C++17 sense), whatever the underlying traversal.
+template <typename Category, typename Reference>
+using iterator_category_t = std::conditional_t<std::is_lvalue_reference<Reference>::value, Category, std::input_iterator_tag>;
+
+} // namespace detail
+
+//------------------------------------------------------------------------------
+// transform
+//------------------------------------------------------------------------------
+
+template <typename It, typename F>
+class transform_iterator
+{
+public:
+    using reference         = decltype(std::declval<F const&>()(*std::declval<It const&>()));
+    using iterator_category = detail::iterator_category_t<typename std::iterator_traits<It>::iterator_category, reference>;
+    using value_type        = std::remove_cv_t<std::remove_reference_t<reference>>;
+    using pointer           = void;
+    using difference_type   = typename std::iterator_traits<It>::difference_type;
+
+private:
+    It it_;
+    F const* f_ = nullptr;
+
+public:
+    constexpr transform_iterator() = default;
+
+    constexpr transform_iterator(It it, F const* f)
+        : it_(it)
+        , f_(f)
+    {
+    }
+
+    constexpr It base() const {
+        return it_;
+    }
+
+    constexpr reference operator*() const {
+        return (*f_)(*it_);
+    }
+
+    constexpr transform_iterator& operator++() {
+        ++it_;
+        return *this;
+    }
+
+    constexpr transform_iterator operator++(int) {
+        auto t = *this;
+        ++(*this);
+        return t;
+    }
+
+    constexpr transform_iterator& operator--() {
+        --it_;
+        return *this;
+    }
+
+    constexpr transform_iterator operator--(int) {
+        auto t = *this;
+        --(*this);
+        return t;
+    }
+
+    constexpr transform_iterator& operator+=(difference_type n) {
+        it_ += n;
+        return *this;
+    }
+
+    constexpr transform_iterator operator+(difference_type n) const {
+        auto t = *this;
+        t += n;
+        return t;
+    }
+
+    constexpr friend transform_iterator operator+(difference_type n, transform_iterator it) {
+        return it + n;
+    }
+
+    constexpr transform_iterator& operator-=(difference_type n) {
+        it_ -= n;
+        return *this;
+    }
+
+    constexpr transform_iterator operator-(difference_type n) const {
+        auto t = *this;
+        t -= n;
+        return t;
+    }
+
+    constexpr difference_type operator-(transform_iterator const& rhs) const {
+        return it_ - rhs.it_;
+    }
+
+    constexpr reference operator[](difference_type index) const {
+        return (*f_)(it_[index]);
+    }
+
+    constexpr friend bool operator==(transform_iterator const& lhs, transform_iterator const& rhs) {
+        return lhs.it_ == rhs.it_;
+    }
+
+    constexpr friend bool operator!=(transform_iterator const& lhs, transform_iterator const& rhs) {
+        return !(lhs == rhs);
+    }
+
+    constexpr friend bool operator<(transform_iterator const& lhs, transform_iterator const& rhs) {
+        return lhs.it_ < rhs.it_;
+    }
+
+    constexpr friend bool operator>(transform_iterator const& lhs, transform_iterator const& rhs) {
+        return rhs < lhs;
+    }
+
+    constexpr friend bool operator<=(transform_iterator const& lhs, transform_iterator const& rhs) {
+        return !(rhs < lhs);
+    }
+
+    constexpr friend bool operator>=(transform_iterator const& lhs, transform_iterator const& rhs) {
+        return !(lhs < rhs);
+    }
+};
+
+// The elements f(x) for the elements x of base. Random-access if base is.
+template <typename Base, typename F>
+class transform_view : public view_base
+{
+public:
+    using iterator        = transform_iterator<detail::view_iterator_t<Base>, F>;
+    using reference       = typename iterator::reference;
+    using value_type      = typename iterator::value_type;
+    using difference_type = typename iterator::difference_type;
+
+private:
+    Base base_;
+    F f_;
+
+public:
+    constexpr transform_view(Base base, F f)
+        : base_(base)
+        , f_(f)
+    {
+    }
+
+    constexpr Base const& base() const {
+        return base_;
+    }
+
+    template <typename B = Base>
+    constexpr auto size() const -> decltype(std::declval<B const&>().size()) {
+        return base_.size();
+    }
+
+    template <typename B = Base>
+    constexpr auto operator[](difference_type index) const -> decltype(std::declval<F const&>()(std::declval<B const&>()[index])) {
+        return f_(base_[index]);
+    }
+
+    constexpr iterator begin() const {
+        return iterator { base_.begin(), &f_ };
+    }
+
+    constexpr iterator end() const {
+        return iterator { base_.end(), &f_ };
+    }
+
+    template <typename G>
+    void for_each(G&& g) const {
+        detail::view_for_each(base_, [&](auto&& x) { g(f_(std::forward<decltype(x)>(x))); });
+    }
+};
+
+template <
+    typename Base, typename F,
+    typename = std::enable_if_t< is_view_source<Base>::value >
+>
+constexpr transform_view<Base, F> transform(Base base, F f)
+{
+    return { base, f };
+}
+
+//------------------------------------------------------------------------------
+// filter
+//------------------------------------------------------------------------------
+
+template <typename It, typename P>
+class filter_iterator
+{
+public:
+    using reference         = typename std::iterator_traits<It>::reference;
+    using iterator_category = detail::iterator_category_t<std::forward_iterator_tag, reference>;
+    using value_type        = typename std::iterator_traits<It>::value_type;
+    using pointer           = void;
+    using difference_type   = typename std::iterator_traits<It>::difference_type;
+
+private:
+    It it_;
+    It last_;
+    P const* p_ = nullptr;
+
+    constexpr void satisfy() {
+        while (it_ != last_ && !(*p_)(*it_))
+            ++it_;
+    }
+
+public:
+    constexpr filter_iterator() = default;
+
+    constexpr filter_iterator(It it, It last, P const* p)
+        : it_(it)
+        , last_(last)
+        , p_(p)
+    {
+        satisfy();
+    }
+
+    constexpr It base() const {
+        return it_;
+    }
+
+    constexpr reference operator*() const {
+        return *it_;
+    }
+
+    constexpr filter_iterator& operator++() {
+        ++it_;
+        satisfy();
+        return *this;
+    }
+
+    constexpr filter_iterator operator++(int) {
+        auto t = *this;
+        ++(*this);
+        return t;
+    }
+
+    constexpr friend bool operator==(filter_iterator const& lhs, filter_iterator const& rhs) {
+        return lhs.it_ == rhs.it_;
+    }
+
+    constexpr friend bool operator!=(filter_iterator const& lhs, filter_iterator const& rhs) {
+        return !(lhs == rhs);
+    }
+};
+
+// The elements x of base for which p(x) is true.
+template <typename Base, typename P>
+class filter_view : public view_base
+{
+public:
+    using iterator        = filter_iterator<detail::view_iterator_t<Base>, P>;
+    using reference       = typename iterator::reference;
+    using value_type      = typename iterator::value_type;
+    using difference_type = typename iterator::difference_type;
+
+private:
+    Base base_;
+    P p_;
+
+public:
+    constexpr filter_view(Base base, P p)
+        : base_(base)
+        , p_(p)
+    {
+    }
+
+    constexpr Base const& base() const {
+        return base_;
+    }
+
+    // O(size of base)
+    constexpr iterator begin() const {
+        return iterator { base_.begin(), base_.end(), &p_ };
+    }
+
+    constexpr iterator end() const {
+        return iterator { base_.end(), base_.end(), &p_ };
+    }
+
+    template <typename G>
+    void for_each(G&& g) const {
+        detail::view_for_each(base_, [&](auto&& x) {
+            if (p_(x))
+                g(std::forward<decltype(x)>(x));
+        });
+    }
+};
+
+template <
+    typename Base, typename P,
+    typename = std::enable_if_t< is_view_source<Base>::value >
+>
+constexpr filter_view<Base, P> filter(Base base, P p)
+{
+    return { base, p };
+}
+
+//------------------------------------------------------------------------------
+// zip
+//------------------------------------------------------------------------------
+
+template <typename... Bases>
+class zip_view;
+
+template <typename... Bases>
+class zip_iterator
+{
+public:
+    using reference         = std::tuple<decltype(std::declval<Bases const&>()[0])...>;
+    using iterator_category = std::input_iterator_tag; // reference is a prvalue
+    using value_type        = reference;
+    using pointer           = void;
+    using difference_type   = std::ptrdiff_t;
+
+private:
+    zip_view<Bases...> const* view_ = nullptr;
+    difference_type pos_ = 0;
+
+public:
+    constexpr zip_iterator() = default;
+
+    constexpr zip_iterator(zip_view<Bases...> const* view, difference_type pos)
+        : view_(view)
+        , pos_(pos)
+    {
+    }
+
+    constexpr reference operator*() const {
+        return (*view_)[pos_];
+    }
+
+    constexpr zip_iterator& operator++() {
+        ++pos_;
+        return *this;
+    }
+
+    constexpr zip_iterator operator++(int) {
+        auto t = *this;
+        ++(*this);
+        return t;
+    }
+
+    constexpr zip_iterator& operator--() {
+        --pos_;
+        return *this;
+    }
+
+    constexpr zip_iterator operator--(int) {
+        auto t = *this;
+        --(*this);
+        return t;
+    }
+
+    constexpr zip_iterator& operator+=(difference_type n) {
+        pos_ += n;
+        return *this;
+    }
+
+    constexpr zip_iterator operator+(difference_type n) const {
+        auto t = *this;
+        t += n;
+        return t;
+    }
+
+    constexpr friend zip_iterator operator+(difference_type n, zip_iterator it) {
+        return it + n;
+    }
+
+    constexpr zip_iterator& operator-=(difference_type n) {
+        pos_ -= n;
+        return *this;
+    }
+
+    constexpr zip_iterator operator-(difference_type n) const {
+        auto t = *this;
+        t -= n;
+        return t;
+    }
+
+    constexpr difference_type operator-(zip_iterator const& rhs) const {
+        assert(view_ == rhs.view_);
+        return pos_ - rhs.pos_;
+    }
+
+    constexpr reference operator[](difference_type index) const {
+        return (*view_)[pos_ + index];
+    }
+
+    constexpr friend bool operator==(zip_iterator const& lhs, zip_iterator const& rhs) {
+        assert(lhs.view_ == rhs.view_);
+        return lhs.pos_ == rhs.pos_;
+    }
+
+    constexpr friend bool operator!=(zip_iterator const& lhs, zip_iterator const& rhs) {
+        return !(lhs == rhs);
+    }
+
+    constexpr friend bool operator<(zip_iterator const& lhs, zip_iterator const& rhs) {
+        assert(lhs.view_ == rhs.view_);
+        return lhs.pos_ < rhs.pos_;
+    }
+
+    constexpr friend bool operator>(zip_iterator const& lhs, zip_iterator const& rhs) {
+        return rhs < lhs;
+    }
+
+    constexpr friend bool operator<=(zip_iterator const& lhs, zip_iterator const& rhs) {
+        return !(rhs < lhs);
+    }
+
+    constexpr friend bool operator>=(zip_iterator const& lhs, zip_iterator const& rhs) {
+        return !(lhs < rhs);
+    }
+};
+
+// The tuples (b0[i], b1[i], ...) for i in [0, min size). All bases must be
+// random-access. Iterators point to the view itself.
+template <typename... Bases>
+class zip_view : public view_base
+{
+    static_assert(sizeof...(Bases) >= 1, "invalid template argument");
+
+public:
+    using iterator        = zip_iterator<Bases...>;
+    using reference       = typename iterator::reference;
+    using value_type      = typename iterator::value_type;
+    using difference_type = typename iterator::difference_type;
+
+private:
+    std::tuple<Bases...> bases_;
+    difference_type size_ = 0;
+
+    template <std::size_t... I>
+    constexpr reference at(difference_type index, std::index_sequence<I...>) const {
+        return reference(std::get<I>(bases_)[index]...);
+    }
+
+    template <std::size_t... I>
+    constexpr difference_type min_size(std::index_sequence<I...>) const {
+        difference_type n = std::get<0>(bases_).size();
+        difference_type const sizes[] = { static_cast<difference_type>(std::get<I>(bases_).size())... };
+        for (auto s : sizes)
+            n = s < n ? s : n;
+        return n;
+    }
+
+public:
+    constexpr zip_view(Bases... bases)
+        : bases_(bases...)
+    {
+        size_ = min_size(std::index_sequence_for<Bases...>{});
+    }
+
+    constexpr difference_type size() const {
+        return size_;
+    }
+
+    constexpr reference operator[](difference_type index) const {
+        assert(index >= 0 && index < size_);
+        return at(index, std::index_sequence_for<Bases...>{});
+    }
+
+    constexpr iterator begin() const {
+        return iterator { this, 0 };
+    }
+
+    constexpr iterator end() const {
+        return iterator { this, size_ };
+    }
+
+    template <typename G>
+    void for_each(G&& g) const {
+        for (difference_type i = 0; i < size_; ++i)
+            g(at(i, std::index_sequence_for<Bases...>{}));
+    }
+};
+
+template <
+    typename... Bases,
+    typename = std::enable_if_t< std::conjunction<is_view_source<Bases>...>::value >
+>
+constexpr zip_view<Bases...> zip(Bases... bases)
+{
+    return { bases... };
+}
+
+//------------------------------------------------------------------------------
+// Algorithms
+//------------------------------------------------------------------------------
+
+// Left fold of the elements of v with op, starting with init.
+template <
+    typename V, typename Acc, typename BinaryOp,
+    typename = std::enable_if_t< is_view<V>::value >
+>
+Acc reduce(V const& v, Acc init, BinaryOp op)
+{
+    v.for_each([&](auto&& x) { init = op(init, std::forward<decltype(x)>(x)); });
+    return init;
+}
+
+template <
+    typename V, typename Acc,
+    typename = std::enable_if_t< is_view<V>::value >
+>
+Acc reduce(V const& v, Acc init)
+{
+    v.for_each([&](auto&& x) { init = init + std::forward<decltype(x)>(x); });
+    return init;
+}
+
+// Writes the elements of v into the front of dst. Returns the remaining part
+// of dst.
+template <
+    typename V, typename T,
+    typename = std::enable_if_t< is_view<V>::value >
+>
+array_ref<T> copy(V const& v, array_ref<T> dst)
+{
+    auto const out = dst.data();
+    std::ptrdiff_t n = 0;
+    v.for_each([&](auto&& x) {
+        assert(n < dst.size());
+        out[n++] = std::forward<decltype(x)>(x);
+    });
+    return dst.drop_front(n);
+}
+
+} // namespace cxx
+
+//------------------------------------------------------------------------------
+// Copyright 2017 A. Bolz
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.